@@ -0,0 +1,40 @@
+#include "Bench.h"
+#include <math.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+BenchReport::BenchReport(const char *suite) : failures_(0)
+{
+  std::cout << suite << std::endl;
+}
+
+bool BenchReport::Check(const char *name, double value, double limit)
+{
+  bool pass = value <= limit;
+  if (!pass)
+    failures_++;
+  std::cout << "  " << std::left << std::setw(44) << name << std::right << std::setw(12)
+            << std::setprecision(4) << value << " (limit " << limit << ") " << (pass ? "ok" : "FAILED")
+            << std::endl;
+  std::cout << std::setprecision(6);
+  return pass;
+}
+
+void BenchReport::Measure(const char *name, double value, const char *unit)
+{
+  std::cout << "  " << std::left << std::setw(44) << name << std::right << std::setw(12)
+            << std::setprecision(4) << value << " " << unit << std::endl;
+  std::cout << std::setprecision(6);
+}
+
+double Separation(double zenithA, double azimuthA, double zenithB, double azimuthB)
+{
+  const double rad = M_PI / 180.0;
+  double ea = (90.0 - zenithA) * rad;
+  double eb = (90.0 - zenithB) * rad;
+  // Haversine form: acos() loses everything below ~1e-8 rad
+  double h = sin((eb - ea) / 2.0) * sin((eb - ea) / 2.0) +
+             cos(ea) * cos(eb) * sin((azimuthB - azimuthA) * rad / 2.0) * sin((azimuthB - azimuthA) * rad / 2.0);
+  return 2.0 * asin(std::min(1.0, sqrt(h))) / rad;
+}
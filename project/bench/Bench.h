@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include "SensorSample.h"
+
+/*************************** USER INPUT DATA ***************************************/
+struct BenchOptions
+{
+  bool full; // Full-size runs behind the quoted numbers; otherwise a quick check pass
+  BenchOptions(const bool &f = false) : full(f) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/**
+ * @brief: Results of one suite. Check() lines carry a limit and fail the run when the
+ *         value exceeds it; Measure() lines are timings, printed only, since they depend
+ *         on the host. Each suite returns GetFailures().
+ */
+class BenchReport
+{
+public:
+  explicit BenchReport(const char *suite);
+
+  /* value must not exceed limit (NaN fails) */
+  bool Check(const char *name, double value, double limit);
+
+  void Measure(const char *name, double value, const char *unit);
+
+  int GetFailures() const { return failures_; }
+
+private:
+  int failures_;
+};
+
+/* Wall time per call of fn() over count calls [ns] */
+template <typename Fn>
+double TimePerCall(std::size_t count, Fn fn)
+{
+  double t0 = MonotonicNow();
+  for (std::size_t i = 0; i < count; i++)
+    fn(i);
+  return (MonotonicNow() - t0) * 1e9 / count;
+}
+
+/* Angle between two sun positions [degrees] */
+double Separation(double zenithA, double azimuthA, double zenithB, double azimuthB);
+
+/* Suites: each returns the number of failed checks */
+int RunSeriesBench(const BenchOptions &options);    // GetSunSeries() against per-call SPA
+int RunSolverBench(const BenchOptions &options);    // SPASunSolver against a brute-force scan
+int RunRatesBench(const BenchOptions &options);     // GetSunRates() against finite differences
+int RunTierBench(const BenchOptions &options);      // Accuracy tiers against the exact tier
+int RunYieldBench(const BenchOptions &options);     // SPAYieldSim throughput, topocentric split
+int RunFieldBench(const BenchOptions &options);     // SPAField grid against O(n^2), tick cost
+int RunHeliostatBench(const BenchOptions &options); // SPAHeliostat batch against per mirror
+int RunTelemetryBench(const BenchOptions &options); // TelemetryLog append cost
+int RunMagCalBench(const BenchOptions &options);    // MagCalibration offsets inside and outside the field
+int RunRingBench(const BenchOptions &options);      // SPSCRing overwrite, tearing and overrun count
+int RunProbeBench(const BenchOptions &options);     // Enabled latency probe cost, bucket bounds
@@ -0,0 +1,242 @@
+#include "Bench.h"
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "SPAField.h"
+#include "SPAHeliostat.h"
+#include "SPAYieldSim.h"
+
+namespace
+{
+  const double RAD = M_PI / 180.0;
+
+  /* Overlap area of two circles of radii a and b, centres d apart */
+  double Lens(double a, double b, double d)
+  {
+    if (d >= a + b)
+      return 0.0;
+    if (d <= fabs(a - b))
+    {
+      double r = std::min(a, b);
+      return M_PI * r * r;
+    }
+    return a * a * acos((d * d + a * a - b * b) / (2.0 * d * a)) + b * b * acos((d * d + b * b - a * a) / (2.0 * d * b)) -
+           0.5 * sqrt(std::max(0.0, (-d + a + b) * (d + a - b) * (d - a + b) * (d + a + b)));
+  }
+
+  /* rows x columns dishes on an 8 x 9 m pitch, jittered, about 6 m apertures */
+  std::vector<FieldDish> MakeField(int rows, int columns, std::mt19937 &rng)
+  {
+    std::uniform_real_distribution<double> jitter(-1.0, 1.0);
+    std::vector<FieldDish> dishes;
+    for (int r = 0; r < rows; r++)
+      for (int c = 0; c < columns; c++)
+        dishes.push_back(FieldDish(c * 8.0 + jitter(rng), r * 9.0 + jitter(rng), 0.5 * jitter(rng),
+                                   6.0 + 0.5 * jitter(rng)));
+    return dishes;
+  }
+
+  double Collecting(const std::vector<DishState> &states)
+  {
+    double total = 0.0;
+    for (const DishState &s : states)
+      total += s.tracking ? 1.0 - s.shaded : 0.0;
+    return total;
+  }
+} // namespace
+
+int RunYieldBench(const BenchOptions &options)
+{
+  BenchReport report("SPAYieldSim, one year at 60 s steps");
+
+  // The shared sun vector plus the per-site stage must stay spa_calculate()
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  double worst = 0.0;
+  for (int k = 0; k < 2000; k++)
+  {
+    DateTimeData dt(2000 + rng() % 51, 1 + rng() % 12, 1 + rng() % 28, rng() % 24, rng() % 60, rng() % 60, 0.0);
+    SiteData site(Position(-80.0 + 160.0 * unit(rng), -180.0 + 360.0 * unit(rng), 3.0 * unit(rng), 0.0),
+                  WeatherData(-20.0 + 60.0 * unit(rng), 700.0 + 400.0 * unit(rng), 50.0), 90.0 * unit(rng),
+                  -180.0 + 360.0 * unit(rng));
+    SPALib lib(site);
+    double jd, deltaT;
+    if (lib.GetJulianDay(dt, &jd, &deltaT) != 0)
+      continue;
+    SunNode node;
+    lib.GetSunNode(jd, deltaT, &node);
+    SunVector v;
+    SPALib::GetSunVector(jd, node, &v);
+    SunPosition split;
+    lib.GetTopocentric(v, &split);
+
+    spa_data spa;
+    spa.year = dt.dt.year;
+    spa.month = dt.dt.month;
+    spa.day = dt.dt.date;
+    spa.hour = dt.tt.hour;
+    spa.minute = dt.tt.minute;
+    spa.second = dt.tt.second;
+    spa.timezone = 0.0;
+    spa.delta_ut1 = dt.GetDelta_UT1();
+    spa.delta_t = dt.GetDelta_T();
+    spa.longitude = site.pos.Longitude;
+    spa.latitude = site.pos.Latitude;
+    spa.elevation = site.pos.Altitude * 1000.0;
+    spa.pressure = site.weather.presure;
+    spa.temperature = site.weather.temp;
+    spa.slope = site.slope;
+    spa.azm_rotation = site.azmRotation;
+    spa.atmos_refract = site.atmosRefract;
+    spa.function = SPA_ZA_INC;
+    spa_calculate(&spa);
+    worst = std::max(worst, Separation(split.zenith, split.azimuth, spa.zenith, spa.azimuth));
+    worst = std::max(worst, fabs(split.incidence - spa.incidence));
+  }
+  report.Check("topocentric split against spa_calculate() [deg]", worst, 1e-9);
+
+  const std::size_t count = options.full ? 1000 : 10;
+  std::vector<YieldSite> sites;
+  for (std::size_t i = 0; i < count; i++)
+    sites.push_back(YieldSite(SiteData(Position(-70.0 + 140.0 * unit(rng), -180.0 + 360.0 * unit(rng), 2.0 * unit(rng), 0.0),
+                                       WeatherData(15.0, 1010.0, 50.0), 60.0 * unit(rng), -90.0 + 180.0 * unit(rng)),
+                              10.0, 0.8));
+  SPAYieldSim sim(YieldConfig(2025, 60.0));
+  std::vector<YieldResult> results;
+  double t0 = MonotonicNow();
+  int errCode = sim.Run(sites, &results);
+  double seconds = MonotonicNow() - t0;
+  report.Check("Run() error code", errCode != 0, 0.0);
+  double steps = static_cast<double>(count) * sim.GetDayCount() * 1440.0;
+  report.Measure("sites", static_cast<double>(count), "");
+  report.Measure("threads", sim.GetPool().GetThreadCount(), "");
+  report.Measure("wall time", seconds, "s");
+  report.Measure("per site step", seconds * 1e9 / steps, "ns");
+  return report.GetFailures();
+}
+
+int RunFieldBench(const BenchOptions &options)
+{
+  BenchReport report("SPAField, dish-field shading");
+  std::mt19937 rng(1);
+  std::vector<FieldDish> small = MakeField(30, 30, rng);
+  std::vector<FieldDish> big = MakeField(100, 100, rng);
+
+  // Without flattening the grid lookup must find exactly what an all-pairs pass finds
+  double worst = 0.0;
+  const double elevations[] = {2.0, 5.0, 10.0, 20.0, 45.0};
+  const double azimuths[] = {90.0, 135.0, 180.0, 250.0};
+  for (double el : elevations)
+  {
+    for (double az : azimuths)
+    {
+      SunPosition sun;
+      sun.zenith = 90.0 - el;
+      sun.azimuth = az;
+      SPAField field(small, FieldConfig(1.0, 1e9));
+      std::vector<DishState> states;
+      field.Update(sun, &states);
+      double s[3] = {sin(sun.zenith * RAD) * sin(az * RAD), sin(sun.zenith * RAD) * cos(az * RAD), cos(sun.zenith * RAD)};
+      for (std::size_t i = 0; i < small.size(); i++)
+      {
+        double area = 0.0, ri = small[i].aperture / 2.0;
+        for (std::size_t j = 0; j < small.size(); j++)
+        {
+          double d[3] = {small[j].east - small[i].east, small[j].north - small[i].north, small[j].up - small[i].up};
+          double along = d[0] * s[0] + d[1] * s[1] + d[2] * s[2];
+          if (i == j || along <= 0.0)
+            continue;
+          double across = sqrt(std::max(0.0, d[0] * d[0] + d[1] * d[1] + d[2] * d[2] - along * along));
+          area += Lens(ri, small[j].aperture / 2.0, across);
+        }
+        worst = std::max(worst, fabs(std::min(1.0, area / (M_PI * ri * ri)) - states[i].shaded));
+      }
+    }
+  }
+  report.Check("grid against all pairs, 30 x 30 field", worst, 1e-9);
+
+  SPAField field(big);
+  std::vector<DishState> states;
+  const std::size_t ticks = options.full ? 20 : 2;
+  const double tickElevations[] = {60.0, 3.0};
+  const char *const names[] = {"100 x 100 field tick, 60 deg sun", "100 x 100 field tick, 3 deg sun"};
+  for (int k = 0; k < 2; k++)
+  {
+    SunPosition sun;
+    sun.zenith = 90.0 - tickElevations[k];
+    sun.azimuth = 120.0;
+    report.Measure(names[k], TimePerCall(ticks, [&](std::size_t) { field.Update(sun, &states); }) / 1e6, "ms");
+  }
+
+  // Laying the worst-shaded dishes flat lets the rows behind them collect
+  SunPosition low;
+  low.zenith = 86.0;
+  low.azimuth = 120.0;
+  SPAField tracking(big, FieldConfig(1.0));
+  tracking.Update(low, &states);
+  double before = Collecting(states);
+  SPAField flattening(big, FieldConfig(0.5));
+  flattening.Update(low, &states);
+  double after = Collecting(states);
+  report.Check("flattening must not lose aperture at 4 deg", before - after, 0.0);
+  report.Measure("collecting, all tracking, 4 deg sun", before, "dishes");
+  report.Measure("collecting, shaded laid flat, 4 deg sun", after, "dishes");
+  return report.GetFailures();
+}
+
+int RunHeliostatBench(const BenchOptions &options)
+{
+  BenchReport report("SPAHeliostat, 10k mirrors on two receivers");
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<double> place(-500.0, 500.0);
+  std::vector<ReceiverPoint> receivers = {ReceiverPoint(0.0, 0.0, 120.0), ReceiverPoint(300.0, 50.0, 90.0)};
+  std::vector<HeliostatMirror> mirrors;
+  for (int i = 0; i < 10000; i++)
+    mirrors.push_back(HeliostatMirror(place(rng), place(rng), 5.0, i % 2));
+  SPAHeliostat field(mirrors, receivers);
+  AimBatch batch;
+  SunPosition sun;
+  sun.zenith = 40.0;
+  sun.azimuth = 150.0;
+
+  // Per mirror reference: both vectors from scratch, then the bisector
+  std::vector<double> az(mirrors.size()), el(mirrors.size()), inc(mirrors.size());
+  auto scalar = [&]() {
+    double z = sun.zenith * RAD, a = sun.azimuth * RAD;
+    for (std::size_t i = 0; i < mirrors.size(); i++)
+    {
+      double s[3] = {sin(z) * sin(a), sin(z) * cos(a), cos(z)};
+      const ReceiverPoint &r = receivers[mirrors[i].receiver];
+      double d[3] = {r.east - mirrors[i].east, r.north - mirrors[i].north, r.up - mirrors[i].up};
+      double l = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+      double n[3];
+      for (int c = 0; c < 3; c++)
+        n[c] = s[c] + d[c] / l;
+      double nl = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      for (int c = 0; c < 3; c++)
+        n[c] /= nl;
+      az[i] = fmod(atan2(n[0], n[1]) / RAD + 360.0, 360.0);
+      el[i] = asin(n[2]) / RAD;
+      inc[i] = acos(s[0] * n[0] + s[1] * n[1] + s[2] * n[2]) / RAD;
+    }
+  };
+  field.Update(sun, &batch);
+  scalar();
+  double worst = 0.0;
+  for (std::size_t i = 0; i < mirrors.size(); i++)
+    worst = std::max({worst, fabs(remainder(az[i] - batch.azimuth[i], 360.0)), fabs(el[i] - batch.elevation[i]),
+                      fabs(inc[i] - batch.incidence[i])});
+  report.Check("batch against per mirror [deg]", worst, 1e-9);
+
+  const std::size_t ticks = options.full ? 200 : 20;
+  report.Measure("batch tick", TimePerCall(ticks, [&](std::size_t k) {
+                   sun.azimuth = 150.0 + k * 0.01;
+                   field.Update(sun, &batch);
+                 }) / 1e3, "us");
+  report.Measure("per mirror tick", TimePerCall(ticks, [&](std::size_t k) {
+                   sun.azimuth = 150.0 + k * 0.01;
+                   scalar();
+                 }) / 1e3, "us");
+  return report.GetFailures();
+}
@@ -0,0 +1,43 @@
+// The probes are timed as an enabled build has them, whatever this build's PROBES option
+#define PST_PROBES
+#include "Bench.h"
+#include <stdint.h>
+#include <algorithm>
+#include "Probe.h"
+
+int RunProbeBench(const BenchOptions &options)
+{
+  BenchReport report("Latency probes, enabled, on the calling thread");
+
+  // Every value falls in a bucket whose upper bound is at most 1/32 above it
+  double worstBucket = 0.0;
+  for (uint64_t ticks = 1; ticks < (uint64_t(1) << PROBE_MAX_BITS); ticks += 1 + ticks / 7)
+  {
+    uint64_t bound = ProbeBucketValue(ProbeBucket(ticks));
+    worstBucket = std::max(worstBucket, bound < ticks ? 1.0 : static_cast<double>(bound - ticks) / ticks);
+  }
+  report.Check("worst bucket bound above the value", worstBucket, 1.0 / (1 << PROBE_SUB_BITS));
+
+  const std::size_t calls = options.full ? 20000000 : 1000000;
+  ProbeThread &thread = GetProbeThread();
+  uint64_t before = 0;
+  for (std::size_t b = 0; b < PROBE_BUCKETS; b++)
+    before += thread.buckets[PROBE_TICK][b].load(std::memory_order_relaxed);
+
+  double scope = TimePerCall(calls, [](std::size_t) {
+    PROBE_SCOPE(PROBE_TICK);
+    __asm__ __volatile__("" ::: "memory"); // Keep the empty scope
+  });
+  uint64_t after = 0;
+  for (std::size_t b = 0; b < PROBE_BUCKETS; b++)
+    after += thread.buckets[PROBE_TICK][b].load(std::memory_order_relaxed);
+  report.Check("scopes not in the histogram", static_cast<double>(calls - (after - before)), 0.0);
+
+  volatile uint64_t sink = 0;
+  double counter = TimePerCall(calls, [&](std::size_t) { sink += ProbeNow(); });
+  report.Measure("PROBE_SCOPE(), empty scope", scope, "ns");
+  report.Measure("counter read (ProbeNow)", counter, "ns");
+  report.Measure("histogram update beyond two reads", scope - 2.0 * counter, "ns");
+  report.Measure("PROBE_COUNT()", TimePerCall(calls, [](std::size_t) { PROBE_COUNT(COUNTER_MOVES, 1); }), "ns");
+  return report.GetFailures();
+}
@@ -0,0 +1,156 @@
+#include "Bench.h"
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MagCalibration.h"
+#include "SPSCRing.h"
+
+namespace
+{
+  const double RADIUS = 74.0; // Field radius in sensor counts
+  const double SOFT_IRON[3][3] = {{1.10, 0.05, -0.03}, {0.02, 0.92, 0.04}, {-0.05, 0.03, 1.03}};
+
+  /* Raw reading of a random field direction through the soft iron, plus the hard-iron offset */
+  Point3f Reading(const double offset[3], std::mt19937 &rng)
+  {
+    std::normal_distribution<double> normal(0.0, 1.0);
+    double t[3], n = 0.0;
+    for (int i = 0; i < 3; i++)
+    {
+      t[i] = normal(rng);
+      n += t[i] * t[i];
+    }
+    double r[3];
+    for (int i = 0; i < 3; i++)
+    {
+      r[i] = offset[i] + 0.1 * normal(rng);
+      for (int k = 0; k < 3; k++)
+        r[i] += SOFT_IRON[i][k] * t[k] * RADIUS / sqrt(n);
+    }
+    return Point3f(r[0], r[1], r[2]);
+  }
+
+  const std::size_t RING = 128; // TrackingDaemon::IMU_RING
+
+  /* A cache line whose words all derive from its index: a torn copy does not check out */
+  struct RingItem
+  {
+    uint64_t index;
+    uint64_t check[7];
+    explicit RingItem(uint64_t i = 0) : index(i)
+    {
+      for (int k = 0; k < 7; k++)
+        check[k] = i * 0x9E3779B97F4A7C15ull + k;
+    }
+    bool IsWhole() const
+    {
+      RingItem expected(index);
+      return std::equal(check, check + 7, expected.check);
+    }
+  };
+} // namespace
+
+int RunRingBench(const BenchOptions &options)
+{
+  BenchReport report("SPSCRing, 128 slots, producer lapping the consumer");
+  RingItem out[RING];
+
+  // Single thread: a full ring keeps the newest items and counts the rest as overruns
+  {
+    SPSCRing<RingItem, RING> ring;
+    for (uint64_t i = 0; i < 2 * RING + 3; i++)
+      ring.Push(RingItem(i));
+    std::size_t n = ring.DrainLatest(out, RING);
+    report.Check("lapped drain: items missing", static_cast<double>(RING - n), 0.0);
+    report.Check("lapped drain: wrong oldest item", n ? fabs(out[0].index - (RING + 3.0)) : NAN, 0.0);
+    report.Check("lapped drain: overrun miscount", fabs(ring.GetOverruns() - (RING + 3.0)), 0.0);
+    for (uint64_t i = 0; i < 10; i++)
+      ring.Push(RingItem(i));
+    n = ring.DrainLatest(out, 4);
+    report.Check("short drain: not the newest 4", (n == 4 && out[0].index == 6 && out[3].index == 9) ? 0.0 : 1.0, 0.0);
+  }
+
+  // Two threads: every item delivered is whole, in order, and delivered + overruns = pushed
+  SPSCRing<RingItem, RING> ring;
+  const uint64_t pushes = options.full ? 50000000 : 2000000;
+  std::atomic<bool> done(false);
+  double t0 = MonotonicNow();
+  std::thread producer([&]() {
+    for (uint64_t i = 0; i < pushes; i++)
+      ring.Push(RingItem(i));
+    done = true;
+  });
+  std::size_t delivered = 0, torn = 0, disorder = 0, drains = 0;
+  uint64_t next = 0;
+  bool last = false;
+  while (!last)
+  {
+    last = done.load();
+    std::size_t n = ring.DrainLatest(out, RING);
+    drains++;
+    for (std::size_t k = 0; k < n; k++)
+    {
+      torn += !out[k].IsWhole();
+      disorder += out[k].index < next;
+      next = out[k].index + 1;
+    }
+    delivered += n;
+  }
+  producer.join();
+  double seconds = MonotonicNow() - t0;
+  report.Check("torn items", static_cast<double>(torn), 0.0);
+  report.Check("items out of order or repeated", static_cast<double>(disorder), 0.0);
+  report.Check("|delivered + overruns - pushed|",
+               fabs(static_cast<double>(delivered + ring.GetOverruns()) - static_cast<double>(pushes)), 0.0);
+  report.Measure("pushes", static_cast<double>(pushes), "");
+  report.Measure("overruns", static_cast<double>(ring.GetOverruns()), "");
+  report.Measure("drains", static_cast<double>(drains), "");
+  report.Measure("push + drain", seconds * 1e9 / pushes, "ns/item");
+  return report.GetFailures();
+}
+
+int RunMagCalBench(const BenchOptions &options)
+{
+  BenchReport report("MagCalibration, soft iron on a 74 count field, hard-iron offset in counts");
+
+  // The fit's sign flips once the offset is longer than the field radius; all must solve
+  const double offsets[] = {40.0, 60.0, 80.0, 150.0};
+  for (double length : offsets)
+  {
+    std::mt19937 rng(1);
+    const double offset[3] = {length * 0.6, -length * 0.48, length * 0.64};
+    MagCalibration cal;
+    cal.SetReference(RADIUS);
+    for (int i = 0; i < 5000; i++)
+      cal.Add(Reading(offset, rng));
+    bool solved = cal.Solve();
+    double worst = 0.0;
+    for (int i = 0; solved && i < 2000; i++)
+    {
+      Point3f c = cal.Apply(Reading(offset, rng));
+      worst = std::max(worst, fabs(sqrt(c.X * c.X + c.Y * c.Y + c.Z * c.Z) - RADIUS) / RADIUS);
+    }
+    const Point3f &o = cal.GetOffset();
+    double miss = sqrt((o.X - offset[0]) * (o.X - offset[0]) + (o.Y - offset[1]) * (o.Y - offset[1]) +
+                       (o.Z - offset[2]) * (o.Z - offset[2]));
+    std::string name = "offset " + std::to_string(static_cast<int>(length)) + ": ";
+    report.Check((name + "Solve() failures").c_str(), solved ? 0.0 : 1.0, 0.0);
+    report.Check((name + "worst calibrated radius error [%]").c_str(), solved ? worst * 100.0 : NAN, 1.0);
+    report.Check((name + "offset error [counts]").c_str(), solved ? miss : NAN, 0.5);
+  }
+
+  std::mt19937 rng(2);
+  const double offset[3] = {40.0, -25.0, 60.0};
+  std::vector<Point3f> samples;
+  for (int i = 0; i < (options.full ? 100000 : 10000); i++)
+    samples.push_back(Reading(offset, rng));
+  MagCalibration cal;
+  report.Measure("Add()", TimePerCall(samples.size(), [&](std::size_t i) { cal.Add(samples[i]); }), "ns");
+  report.Measure("Solve()", TimePerCall(options.full ? 100000 : 10000, [&](std::size_t) { cal.Solve(); }), "ns");
+  return report.GetFailures();
+}
@@ -0,0 +1,297 @@
+#include "Bench.h"
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "SPALib.h"
+#include "SPASunSolver.h"
+
+namespace
+{
+  const double TIMEZONE = -7.0;
+
+  SiteData Calgary()
+  {
+    return SiteData(Position(51.047, -114.063, 1.181, 0.0), WeatherData(18.0, 895.0, 56.0), 30.0, -10.0);
+  }
+
+  DateTimeData AtSecond(const Date &day, int second, double timezone)
+  {
+    return DateTimeData(day, Time(second / 3600, (second / 60) % 60, second % 60, timezone));
+  }
+
+  /* One-second bracket of each crossing of f(second) through zero on a minute grid;
+     a sign change with a jump of half a turn or more is a wrap, not a crossing */
+  template <typename Fn>
+  std::vector<int> BruteCrossings(Fn f, double wrap)
+  {
+    std::vector<int> found;
+    double prev = f(0);
+    for (int s = 60; s < 86400; s += 60)
+    {
+      double g = f(s);
+      if ((prev < 0.0) != (g < 0.0) && (wrap <= 0.0 || fabs(g - prev) < wrap / 2.0))
+      {
+        for (int u = s - 59; u <= s; u++)
+        {
+          if ((f(u) < 0.0) != (prev < 0.0))
+          {
+            found.push_back(u);
+            break;
+          }
+        }
+      }
+      prev = g;
+    }
+    return found;
+  }
+
+  /* Seconds a solver root lies outside the brute-force bracket (u - 1, u], 0 inside */
+  double Outside(double hour, int u)
+  {
+    double d = hour * 3600.0 - u;
+    return std::max(0.0, std::max(d, -1.0 - d));
+  }
+} // namespace
+
+int RunSeriesBench(const BenchOptions &options)
+{
+  BenchReport report("GetSunSeries, 1 minute steps over a day, against GetSunPosition");
+  SPALib lib(Calgary());
+  const std::size_t count = 1440;
+  std::vector<SunPosition> series(count);
+  double worst = 0.0;
+  const int step = options.full ? 1 : 4;
+  for (int month = 1; month <= 12; month += step)
+  {
+    Date day(2025, month, 15);
+    lib.GetSunSeries(DateTimeData(day, Time(0, 0, 0, TIMEZONE)), 60.0, count, series.data());
+    for (std::size_t i = 0; i < count; i++)
+    {
+      SunPosition exact = lib.GetSunPosition(AtSecond(day, static_cast<int>(i) * 60, TIMEZONE)).pos;
+      worst = std::max(worst, fabs(exact.zenith - series[i].zenith));
+      worst = std::max(worst, fabs(remainder(exact.azimuth - series[i].azimuth, 360.0)));
+      worst = std::max(worst, fabs(exact.incidence - series[i].incidence));
+    }
+  }
+  report.Check("worst deviation [deg]", worst, 1e-5);
+
+  Date day(2025, 6, 15);
+  const std::size_t repeats = options.full ? 20 : 2;
+  double perSeries = TimePerCall(repeats, [&](std::size_t) {
+    lib.GetSunSeries(DateTimeData(day, Time(0, 0, 0, TIMEZONE)), 60.0, count, series.data());
+  }) / count;
+  volatile double sink = 0.0;
+  double perCall = TimePerCall(repeats * count, [&](std::size_t i) {
+    sink += lib.GetSunPosition(AtSecond(day, static_cast<int>(i % count) * 60, TIMEZONE)).pos.zenith;
+  });
+  report.Measure("series", perSeries, "ns/sample");
+  report.Measure("per-call GetSunPosition()", perCall, "ns/sample");
+  report.Measure("speedup", perCall / perSeries, "x");
+  return report.GetFailures();
+}
+
+int RunSolverBench(const BenchOptions &options)
+{
+  BenchReport report("SPASunSolver, against a one-second brute-force scan");
+  SPALib lib(Calgary());
+  SPARtsCache cache;
+  SPASunSolver solver(lib, cache);
+  const double elevations[] = {-6.0, 0.0, 10.0, 30.0};
+  const double azimuths[] = {90.0, 180.0, 270.0};
+  double worst = 0.0;
+  int mismatches = 0, crossings = 0;
+  const int step = options.full ? 1 : 3;
+  for (int month = 1; month <= 12; month += step)
+  {
+    Date day(2025, month, 10);
+    for (double target : elevations)
+    {
+      std::vector<int> brute = BruteCrossings(
+          [&](int s) { return 90.0 - lib.GetSunPosition(AtSecond(day, s, TIMEZONE)).pos.zenith - target; }, 0.0);
+      SunEvent ev = solver.TimeAtElevation(day, TIMEZONE, target);
+      mismatches += static_cast<int>(brute.size()) != ev.count;
+      for (int i = 0; i < ev.count && i < static_cast<int>(brute.size()); i++, crossings++)
+        worst = std::max(worst, Outside(ev.hour[i], brute[i]));
+    }
+    for (double target : azimuths)
+    {
+      std::vector<int> brute = BruteCrossings(
+          [&](int s) { return remainder(lib.GetSunPosition(AtSecond(day, s, TIMEZONE)).pos.azimuth - target, 360.0); },
+          360.0);
+      SunEvent ev = solver.TimeAtAzimuth(day, TIMEZONE, target);
+      std::size_t k = 0;
+      for (int i = 0; i < ev.count; i++)
+      {
+        if (ev.hour[i] < 0.0 || ev.hour[i] >= 24.0)
+          continue; // The neighbouring day's crossing
+        if (k < brute.size())
+        {
+          worst = std::max(worst, Outside(ev.hour[i], brute[k]));
+          crossings++;
+        }
+        k++;
+      }
+      mismatches += k != brute.size();
+    }
+  }
+  report.Check("crossing count mismatches", mismatches, 0.0);
+  report.Check("worst root outside the 1 s bracket [s]", worst, 0.01);
+  report.Measure("crossings compared", crossings, "");
+
+  // Low latitude in summer: the sun passes close to the zenith and the azimuth sweeps
+  // half a turn around the transit, far more than the scan step sees at once
+  double lowWorst = 0.0;
+  int lowMismatches = 0, lowCrossings = 0;
+  const double latitudes[] = {23.3, 23.6, 24.5};
+  const double lowAzimuths[] = {85.0, 88.0, 90.0, 270.0, 272.0, 275.0};
+  for (double latitude : latitudes)
+  {
+    SPALib low(SiteData(Position(latitude, -100.0, 0.5, 0.0), WeatherData(25.0, 1010.0, 60.0)));
+    SPARtsCache lowCache;
+    SPASunSolver lowSolver(low, lowCache);
+    Date day(2025, 6, 21);
+    for (double target : lowAzimuths)
+    {
+      std::vector<int> brute = BruteCrossings(
+          [&](int s) { return remainder(low.GetSunPosition(AtSecond(day, s, -6.0)).pos.azimuth - target, 360.0); },
+          360.0);
+      SunEvent ev = lowSolver.TimeAtAzimuth(day, -6.0, target);
+      std::size_t k = 0;
+      for (int i = 0; i < ev.count; i++)
+      {
+        if (ev.hour[i] < 0.0 || ev.hour[i] >= 24.0)
+          continue;
+        if (k < brute.size())
+        {
+          lowWorst = std::max(lowWorst, Outside(ev.hour[i], brute[k]));
+          lowCrossings++;
+        }
+        k++;
+      }
+      lowMismatches += k != brute.size();
+    }
+  }
+  report.Check("low latitude summer: count mismatches", lowMismatches, 0.0);
+  report.Check("low latitude summer: worst outside bracket [s]", lowWorst, 0.01);
+  report.Measure("low latitude crossings compared", lowCrossings, "");
+
+  Date day(2025, 6, 1);
+  solver.TimeAtElevation(day, TIMEZONE, 5.0); // First query of the day builds the ephemeris
+  const std::size_t queries = options.full ? 10000 : 1000;
+  volatile double sink = 0.0;
+  report.Measure("elevation query", TimePerCall(queries, [&](std::size_t i) {
+                   sink += solver.TimeAtElevation(day, TIMEZONE, 5.0 + i % 20).hour[0];
+                 }) / 1e3, "us");
+  report.Measure("azimuth query", TimePerCall(queries, [&](std::size_t i) {
+                   sink += solver.TimeAtAzimuth(day, TIMEZONE, 100.0 + i % 100).hour[0];
+                 }) / 1e3, "us");
+  return report.GetFailures();
+}
+
+int RunRatesBench(const BenchOptions &options)
+{
+  BenchReport report("GetSunRates, against central differences over +/-60 s");
+  SPALib lib(Calgary());
+  const double h = 60.0;
+  double rateError = 0.0, azAccelError = 0.0, elAccelError = 0.0;
+  const int step = options.full ? 1 : 3;
+  for (int month = 1; month <= 12; month += step)
+  {
+    for (int hour = 5; hour <= 20; hour++)
+    {
+      SunRates r = lib.GetSunRates(DateTimeData(2025, month, 10, hour, 30, 30, TIMEZONE));
+      double elevation = 90.0 - r.pos.zenith;
+      if (elevation < 1.0)
+        continue; // Refraction is clipped at the horizon: no smooth derivative there
+      SunPosition m = lib.GetSunPosition(DateTimeData(2025, month, 10, hour, 29, 30, TIMEZONE)).pos;
+      SunPosition p = lib.GetSunPosition(DateTimeData(2025, month, 10, hour, 31, 30, TIMEZONE)).pos;
+      double azRate = remainder(p.azimuth - m.azimuth, 360.0) / (2.0 * h);
+      double elRate = ((90.0 - p.zenith) - (90.0 - m.zenith)) / (2.0 * h);
+      double azAccel = (remainder(p.azimuth - r.pos.azimuth, 360.0) - remainder(r.pos.azimuth - m.azimuth, 360.0)) / (h * h);
+      double elAccel = (r.pos.zenith - p.zenith - (m.zenith - r.pos.zenith)) / (h * h);
+      // Rate errors relative to the sun's angular speed on the sky
+      double cosEl = cos(elevation * M_PI / 180.0);
+      double speed = hypot(azRate * cosEl, elRate);
+      rateError = std::max(rateError, hypot((r.azimuthRate - azRate) * cosEl, r.elevationRate - elRate) / speed);
+      azAccelError = std::max(azAccelError, fabs(r.azimuthAccel - azAccel));
+      elAccelError = std::max(elAccelError, fabs(r.elevationAccel - elAccel));
+    }
+  }
+  report.Check("worst relative rate error", rateError, 1e-4);
+  report.Check("worst azimuth acceleration error [deg/s^2]", azAccelError, 1e-9);
+  report.Check("worst elevation acceleration error [deg/s^2]", elAccelError, 1e-9);
+
+  // pos is documented as GetSunPosition() at the same tier, bit for bit
+  int posMismatches = 0;
+  const int tiers[] = {SPA_TIER_EXACT, SPA_TIER_TRUNCATED, SPA_TIER_PSA};
+  for (int tier : tiers)
+  {
+    SPALib tiered(Calgary(), tier);
+    for (int hour = 0; hour < 24; hour += 3)
+    {
+      DateTimeData dt(2025, 3, 20, hour, 15, 0, TIMEZONE);
+      SunPosition r = tiered.GetSunRates(dt).pos, p = tiered.GetSunPosition(dt).pos;
+      if (r.zenith != p.zenith || r.azimuth != p.azimuth || r.incidence != p.incidence)
+        posMismatches++;
+    }
+  }
+  report.Check("positions unlike GetSunPosition() at any tier", posMismatches, 0);
+
+  DateTimeData dt(2025, 6, 10, 9, 0, 0, TIMEZONE);
+  const std::size_t calls = options.full ? 20000 : 2000;
+  volatile double sink = 0.0;
+  report.Measure("analytic GetSunRates()", TimePerCall(calls, [&](std::size_t) {
+                   sink += lib.GetSunRates(dt).azimuthRate;
+                 }) / 1e3, "us");
+  report.Measure("three GetSunPosition()", TimePerCall(calls, [&](std::size_t) {
+                   sink += lib.GetSunPosition(dt).pos.azimuth + lib.GetSunPosition(dt).pos.azimuth +
+                           lib.GetSunPosition(dt).pos.azimuth;
+                 }) / 1e3, "us");
+  return report.GetFailures();
+}
+
+int RunTierBench(const BenchOptions &options)
+{
+  BenchReport report("Accuracy tiers, random instants and sites 2000-2050, against the exact tier");
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> latitude(-60.0, 60.0), longitude(-180.0, 180.0);
+  const std::size_t count = options.full ? 30000 : 3000;
+  std::vector<DateTimeData> times;
+  std::vector<Position> places;
+  for (std::size_t k = 0; k < count; k++)
+  {
+    int year = 2000 + rng() % 51, month = 1 + rng() % 12, date = 1 + rng() % 28;
+    int hour = rng() % 24, minute = rng() % 60, second = rng() % 60;
+    times.push_back(DateTimeData(year, month, date, hour, minute, second, 0.0));
+    places.push_back(Position(latitude(rng), longitude(rng), 0.5, 0.0));
+  }
+
+  const int tiers[] = {SPA_TIER_TRUNCATED, SPA_TIER_PSA};
+  const char *const names[] = {"worst truncated tier error [deg]", "worst PSA tier error [deg]"};
+  const double limits[] = {0.001, 0.012};
+  for (int t = 0; t < 2; t++)
+  {
+    double worst = 0.0;
+    for (std::size_t k = 0; k < count; k++)
+    {
+      SiteData site(places[k], WeatherData(15.0, 1010.0, 50.0));
+      SunPosition a = SPALib(site).GetSunPosition(times[k]).pos;
+      SunPosition b = SPALib(site, tiers[t]).GetSunPosition(times[k]).pos;
+      worst = std::max(worst, Separation(a.zenith, a.azimuth, b.zenith, b.azimuth));
+    }
+    report.Check(names[t], worst, limits[t]);
+  }
+
+  const char *const costs[] = {"exact tier", "truncated tier", "PSA tier"};
+  const std::size_t calls = std::min<std::size_t>(count, 20000);
+  for (int tier = SPA_TIER_EXACT; tier <= SPA_TIER_PSA; tier++)
+  {
+    SPALib lib(Calgary(), tier);
+    volatile double sink = 0.0;
+    report.Measure(costs[tier], TimePerCall(calls, [&](std::size_t k) {
+                     sink += lib.GetSunPosition(times[k]).pos.zenith;
+                   }) / 1e3, "us/evaluation");
+  }
+  return report.GetFailures();
+}
@@ -0,0 +1,67 @@
+#include <string.h>
+#include <iostream>
+#include "Bench.h"
+
+namespace
+{
+  struct Suite
+  {
+    const char *name;
+    int (*run)(const BenchOptions &options);
+  };
+
+  const Suite SUITES[] = {
+      {"series", RunSeriesBench},
+      {"solver", RunSolverBench},
+      {"rates", RunRatesBench},
+      {"tiers", RunTierBench},
+      {"yield", RunYieldBench},
+      {"field", RunFieldBench},
+      {"heliostat", RunHeliostatBench},
+      {"telemetry", RunTelemetryBench},
+      {"magcal", RunMagCalBench},
+      {"ring", RunRingBench},
+      {"probes", RunProbeBench},
+  };
+} // namespace
+
+int main(int argc, char **argv)
+{
+  // Usage: bench [--full] [suite ...]
+  // Without --full every suite runs reduced: all the accuracy checks, short timings (ctest).
+  // --full repeats the runs the performance figures were measured with. The bench links
+  // its own -O2 build of the SPALib sources, so the timings are -O2 like the figures
+  // whatever the tree's build type (the tree builds Debug).
+  BenchOptions options;
+  bool selected[sizeof(SUITES) / sizeof(SUITES[0])] = {false};
+  bool any = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--full") == 0)
+    {
+      options.full = true;
+      continue;
+    }
+    bool known = false;
+    for (std::size_t s = 0; s < sizeof(SUITES) / sizeof(SUITES[0]); s++)
+    {
+      if (strcmp(argv[i], SUITES[s].name) == 0)
+        selected[s] = known = any = true;
+    }
+    if (!known)
+    {
+      std::cerr << "Unknown suite " << argv[i] << std::endl;
+      return 2;
+    }
+  }
+
+  int failures = 0;
+  for (std::size_t s = 0; s < sizeof(SUITES) / sizeof(SUITES[0]); s++)
+  {
+    if (!any || selected[s])
+      failures += SUITES[s].run(options);
+  }
+  if (failures > 0)
+    std::cout << failures << " check(s) FAILED" << std::endl;
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <time.h>
+#include "IDateTime.h"
+
+/* One clock reading, in every form the engines take */
+struct ClockTime
+{
+  DateTimeData local; // Local calendar time, whole seconds (1-based month)
+  double fraction;    // Sub-second part of local [s]
+  double unixTime;    // Seconds since 1970-01-01 00:00 UTC
+  double jdUtc;       // Julian day on the UTC scale; add UT1-UTC for the SPA engine
+  double decimalYear; // Leap-year aware, for WMMLib's InData::decimalYear
+  ClockTime() : local(0, 0, 0, 0, 0, 0, 0.0), fraction(0.0), unixTime(0.0), jdUtc(0.0),
+                decimalYear(0.0) {}
+};
+
+/**
+ * @brief: IDateTime with sub-millisecond resolution. CLOCK_REALTIME is read once, at
+ *         Anchor(); after that time advances with CLOCK_MONOTONIC, so NTP slewing or a
+ *         wall clock step cannot make the tracking loop jump. The calendar breakdown is
+ *         cached: a new second is carried forward arithmetically, and localtime_r()
+ *         (which takes the libc timezone lock) only runs on the local hour boundary,
+ *         where DST changes happen, and on day rollover.
+ *
+ *         Not thread-safe: give each loop thread its own clock.
+ */
+class HighResClock : public IDateTime
+{
+public:
+  HighResClock() : realAnchor_(0.0), monoAnchor_(0.0), second_(0), hourEnd_(0), yday_(0),
+                   valid_(false), local_(0, 0, 0, 0, 0, 0, 0.0)
+  {
+    Anchor();
+  }
+
+  /**
+   * @brief: Re-read the wall clock, e.g. once NTP has synchronised after boot.
+   */
+  void Anchor()
+  {
+    // Bracket the realtime read between two monotonic reads, keep the tightest try
+    double best = -1.0;
+    for (int i = 0; i < 3; i++)
+    {
+      double m0 = Read(CLOCK_MONOTONIC);
+      double r = Read(CLOCK_REALTIME);
+      double m1 = Read(CLOCK_MONOTONIC);
+      if (best < 0.0 || m1 - m0 < best)
+      {
+        best = m1 - m0;
+        realAnchor_ = r;
+        monoAnchor_ = 0.5 * (m0 + m1);
+      }
+    }
+    valid_ = false;
+  }
+
+  ClockTime Now() const
+  {
+    ClockTime now;
+    now.unixTime = realAnchor_ + (Read(CLOCK_MONOTONIC) - monoAnchor_);
+
+    time_t second = static_cast<time_t>(floor(now.unixTime));
+    if (!valid_ || second < second_ || second >= hourEnd_)
+      Breakdown(second);
+    else if (second != second_)
+      Advance(second);
+
+    now.local = local_;
+    now.fraction = now.unixTime - second;
+    now.jdUtc = now.unixTime / 86400.0 + 2440587.5;
+
+    double days = local_.dt.IsLeapYear() ? 366.0 : 365.0;
+    double secondOfDay = local_.tt.hour * 3600 + local_.tt.minute * 60 + local_.tt.second;
+    now.decimalYear = local_.dt.year + (yday_ + (secondOfDay + now.fraction) / 86400.0) / days;
+    return now;
+  }
+
+  /* Seconds since the anchor, for deadlines and latency measurement */
+  double GetMonotonic() const { return Read(CLOCK_MONOTONIC) - monoAnchor_; }
+
+  virtual DateTimeData GetDateTimeDate() const override { return Now().local; }
+  virtual double GetDecimalYear() const override { return Now().decimalYear; }
+
+private:
+  static double Read(clockid_t id)
+  {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+  }
+
+  void Breakdown(time_t second) const
+  {
+    struct tm ltm;
+    localtime_r(&second, &ltm);
+    double offset_hours = 0.0;
+#ifdef __GLIBC__ // tm_gmtoff is a glibc extension
+    offset_hours = static_cast<double>(ltm.tm_gmtoff) / 3600.0;
+#endif
+    local_ = DateTimeData(1900 + ltm.tm_year, ltm.tm_mon + 1, ltm.tm_mday, ltm.tm_hour,
+                          ltm.tm_min, ltm.tm_sec, offset_hours);
+    yday_ = ltm.tm_yday;
+    second_ = second;
+    hourEnd_ = second + 3600 - (ltm.tm_min * 60 + ltm.tm_sec);
+    valid_ = true;
+  }
+
+  void Advance(time_t second) const
+  {
+    // Still inside the cached hour: only minutes and seconds move
+    long secondOfHour = local_.tt.minute * 60 + local_.tt.second + (second - second_);
+    local_.tt.minute = static_cast<int>(secondOfHour / 60);
+    local_.tt.second = static_cast<int>(secondOfHour % 60);
+    second_ = second;
+  }
+
+  double realAnchor_;
+  double monoAnchor_;
+  mutable time_t second_;
+  mutable time_t hourEnd_;
+  mutable int yday_;
+  mutable bool valid_;
+  mutable DateTimeData local_;
+};
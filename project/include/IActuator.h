@@ -0,0 +1,31 @@
+#pragma once
+
+/* One planned dish move, see MotionPlanner: a jerk-limited profile from rest to rest */
+struct MoveCommand
+{
+  double startTime;    // Unix time the move starts [s]
+  double duration;     // Both axes arrive together [s]
+  double azimuth;      // End position, base frame [degrees, 0-360)
+  double elevation;    // End position [degrees]
+  double azimuthTravel;   // Signed azimuth travel, through the shorter way round [degrees]
+  double elevationTravel; // Signed elevation travel [degrees]
+  MoveCommand()
+      : startTime(0.0), duration(0.0), azimuth(0.0), elevation(0.0), azimuthTravel(0.0),
+        elevationTravel(0.0) {}
+};
+
+/* Dish drive. Angles are in the dish base frame: azimuth clockwise from the base's
+   forward (IMU x) axis, elevation above the horizon, both in degrees. */
+class IActuator
+{
+public:
+  virtual int Initialize() { return 0; }
+  virtual int SendCommand(const double &azimuth, const double &elevation)
+  {
+    (void)azimuth;
+    (void)elevation;
+    return 0;
+  }
+  /* Drives that run their own profiles take the whole move; the default sends the end point */
+  virtual int SendMove(const MoveCommand &move) { return SendCommand(move.azimuth, move.elevation); }
+};
@@ -46,6 +46,29 @@ struct Date
   int date;
   Date(const int &y, const int &mn, const int &d)
       : year(y), month(mn), date(d) {}
+
+  bool IsLeapYear() const
+  {
+    return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+  }
+
+  /* Calendar date of the following day (month is 1-based) */
+  Date NextDay() const
+  {
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int last = days[month - 1] + ((month == 2 && IsLeapYear()) ? 1 : 0);
+
+    if (date < last)
+      return Date(year, month, date + 1);
+    if (month < 12)
+      return Date(year, month + 1, 1);
+    return Date(year + 1, 1, 1);
+  }
+
+  bool operator==(const Date &o) const
+  {
+    return year == o.year && month == o.month && date == o.date;
+  }
 };
 
 struct Time
@@ -70,35 +93,23 @@ struct DateTimeData
   double GetDelta_UT1() const
   {
     /* Calculate the Julian Date */
-    auto JD = [&] -> double
-    {
-      double A = dt.year / 100.0;
-      double B = A / 4.0;
-      double C = 2 - A + B;
-      double E = 365.25 * (dt.year + 4716);
-      double F = 30.6001 * (dt.month + 1);
-      return C + dt.date + E + F - 1524.5;
-    };
+    double A = dt.year / 100.0;
+    double B = A / 4.0;
+    double C = 2 - A + B;
+    double E = 365.25 * (dt.year + 4716);
+    double F = 30.6001 * (dt.month + 1);
+    double JD = C + dt.date + E + F - 1524.5;
     /* Calculate the Modified Julian Date */
-    double MJD = JD() - 2400000.5;
+    double MJD = JD - 2400000.5;
     /* Calculate the Besselian Year */
-    double T = 1900.0 + (JD() - 2415020.31352) / 365.242198781;
+    double T = 1900.0 + (JD - 2415020.31352) / 365.242198781;
     /* Calculate the UT2 - UT1 */
     double diff_UT2_UT1 = (0.022 * sin(2 * PI * T)) -
                           (0.012 * cos(2 * PI * T)) -
                           (0.006 * sin(4 * PI * T)) +
                           (0.007 * cos(4 * PI * T));
 
-    double A = 2 * PI * (MJD - 60866) / 365.25;
-    double C = 2 * PI * (MJD - 60866) / 435.0;
-
-    double x = 0.1332 + 0.0566 * cos(A) + 0.1483 * sin(A) -
-               0.0151 * cos(C) - 0.0861 * sin(C);
-
-    double y = 0.3838 + (0.1403 * cos(A)) - (0.0484 * sin(A)) -
-               (0.0861 * cos(C)) + (0.0151 * sin(C));
-
-    /* return UT1_UTC */
+    /* return UT1_UTC (see SPATimeScale for the tabulated, memoised values) */
     return (0.0590 + (0.00011 * (MJD - 60874)) - diff_UT2_UT1);
   }
 
@@ -124,12 +135,16 @@ public:
       offset_hours = static_cast<double>(ltm->tm_gmtoff) / 3600.0;
     }
 #endif
-    return DateTimeData((1900 + ltm->tm_year), ltm->tm_mon, ltm->tm_mday, ltm->tm_hour, ltm->tm_min, ltm->tm_sec, offset_hours);
+    // tm_mon is 0-based, Date::month is 1-based
+    return DateTimeData((1900 + ltm->tm_year), ltm->tm_mon + 1, ltm->tm_mday, ltm->tm_hour, ltm->tm_min, ltm->tm_sec, offset_hours);
   }
   virtual double GetDecimalYear() const
   {
     std::time_t now = std::time(nullptr);
     std::tm *ltm = std::localtime(&now);
-    return static_cast<double>(1900 + ltm->tm_year + (ltm->tm_yday + 1) / 365.0);
+    int year = 1900 + ltm->tm_year;
+    double days = Date(year, 1, 1).IsLeapYear() ? 366.0 : 365.0;
+    double dayFraction = (ltm->tm_hour * 3600 + ltm->tm_min * 60 + ltm->tm_sec) / 86400.0;
+    return year + (ltm->tm_yday + dayFraction) / days;
   }
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ISensor.h"
+#include "SensorSample.h"
 
 struct Position
 {
@@ -19,4 +20,24 @@ public:
   virtual int Initialize() override { return 0; }
   virtual void GetRawSensorData() override {}
   virtual Position GetPositionData() const { return Position(51.047, -114.063, 1.181, 0.0); }
+
+  /**
+   * @brief: Batch read. Zero-copy view of the fixes the driver received since the
+   *         previous call, oldest first, valid until the next call on this sensor.
+   *         Default: a single fix from GetPositionData(), stamped now.
+   */
+  virtual SampleSpan<const Timestamped<Position>> GetPositionSamples()
+  {
+    latest_ = Timestamped<Position>(MonotonicNow(), GetPositionData());
+    return SampleSpan<const Timestamped<Position>>(&latest_, 1);
+  }
+
+  /* Batch read into a caller-owned span, see CopyLatest() */
+  std::size_t ReadPositionSamples(const SampleSpan<Timestamped<Position>> &out)
+  {
+    return CopyLatest(GetPositionSamples(), out);
+  }
+
+private:
+  Timestamped<Position> latest_;
 };
\ No newline at end of file
@@ -1,12 +1,14 @@
 #pragma once
 #include "ISensor.h"
 #include "Point.h"
+#include "SensorSample.h"
 
+/* Body frame x forward, y left, z up */
 struct IMUSensorData
 {
-  Point3f accel;
-  Point3f gyro;
-  Point3f mag;
+  Point3f accel; // [m/s^2], +g on z when level and at rest
+  Point3f gyro;  // [rad/s]
+  Point3f mag;   // Raw field, any unit
   IMUSensorData() : accel(Point3f()), gyro(Point3f()), mag(Point3f()) {}
 };
 
@@ -15,8 +17,35 @@ class IMUSensor : public ISensor
 public:
   virtual int Initialize() override { return 0; }
   virtual void GetRawSensorData() override {}
-  virtual Point3f Get3DAccelerometerData() const { return Point3f(); }
+  virtual Point3f Get3DAccelerometerData() const { return Point3f(0.0, 0.0, 9.81); }
   virtual Point3f Get3DGyroscopeData() const { return Point3f(); }
   virtual Point3f Get3DMagneticData() const { return Point3f(-47.5, -21.1, -53.7); }
-  virtual IMUSensorData GetIMUSensorData() const { return IMUSensorData(); }
+  virtual IMUSensorData GetIMUSensorData() const
+  {
+    IMUSensorData data;
+    data.accel = Get3DAccelerometerData();
+    data.gyro = Get3DGyroscopeData();
+    data.mag = Get3DMagneticData();
+    return data;
+  }
+
+  /**
+   * @brief: Batch read. Zero-copy view of the samples the driver captured since the
+   *         previous call, oldest first, valid until the next call on this sensor.
+   *         Default: a single sample from GetIMUSensorData(), stamped now.
+   */
+  virtual SampleSpan<const Timestamped<IMUSensorData>> GetIMUSamples()
+  {
+    latest_ = Timestamped<IMUSensorData>(MonotonicNow(), GetIMUSensorData());
+    return SampleSpan<const Timestamped<IMUSensorData>>(&latest_, 1);
+  }
+
+  /* Batch read into a caller-owned span, see CopyLatest() */
+  std::size_t ReadIMUSamples(const SampleSpan<Timestamped<IMUSensorData>> &out)
+  {
+    return CopyLatest(GetIMUSamples(), out);
+  }
+
+private:
+  Timestamped<IMUSensorData> latest_;
 };
\ No newline at end of file
@@ -1,10 +1,12 @@
 #pragma once
+#include "SensorSample.h"
 
 struct WeatherData
 {
   double temp;
   double presure;
   double humidity;
+  WeatherData() : temp(0.0), presure(0.0), humidity(0.0) {}
   WeatherData(const double &t, const double &p, const double &h)
       : temp(t), presure(p), humidity(h) {}
 };
@@ -16,4 +18,24 @@ public:
   {
     return WeatherData(18.0, 895.0, 56.0);
   }
+
+  /**
+   * @brief: Batch read. Zero-copy view of the readings the station reported since the
+   *         previous call, oldest first, valid until the next call on this source.
+   *         Default: a single reading from GetWeatherData(), stamped now.
+   */
+  virtual SampleSpan<const Timestamped<WeatherData>> GetWeatherSamples()
+  {
+    latest_ = Timestamped<WeatherData>(MonotonicNow(), GetWeatherData());
+    return SampleSpan<const Timestamped<WeatherData>>(&latest_, 1);
+  }
+
+  /* Batch read into a caller-owned span, see CopyLatest() */
+  std::size_t ReadWeatherSamples(const SampleSpan<Timestamped<WeatherData>> &out)
+  {
+    return CopyLatest(GetWeatherSamples(), out);
+  }
+
+private:
+  Timestamped<WeatherData> latest_;
 };
\ No newline at end of file
@@ -0,0 +1,177 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*************************** USER INPUT DATA ***************************************/
+enum PROBE
+{
+  PROBE_DECLINATION = 0, // getDeclinition(): WMM.COF parsed on every call
+  PROBE_WMM,             // WMMEngine::GetDeclination(), memo hits included
+  PROBE_SPA,             // SPALib::GetSunPosition(): full SPA series
+  PROBE_IMU_READ,        // Driver read of the IMU (sampler thread)
+  PROBE_GPS_READ,        // Driver read of the GPS (sampler thread)
+  PROBE_WEATHER_READ,    // Weather source read in the sun stage
+  PROBE_SENSORS,         // TrackingCore::ReadSensors()
+  PROBE_HEADING,         // TrackingCore::UpdateHeading()
+  PROBE_SUN,             // TrackingCore::UpdateSun()
+  PROBE_COMMAND,         // TrackingCore::SendCommand(): planning and actuator output
+  PROBE_TICK,            // One control tick, or one fleet tracker step
+  PROBE_STAGES,
+};
+
+enum COUNTER
+{
+  COUNTER_WMM_MEMO = 0, // WMMEngine calls answered from the memo
+  COUNTER_IMU_SAMPLES,  // IMU samples fused
+  COUNTER_MOVES,        // Actuator commands and planned moves sent
+  COUNTER_MISSED,       // Deadlines missed (daemon periods, fleet tracker deadlines)
+  COUNTER_COUNT,
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/* Log-linear buckets, HDR style: 32 per power of two (3% resolution) up to 2^36 counter
+   ticks (23 s of a 3 GHz TSC) */
+static const int PROBE_SUB_BITS = 5;
+static const int PROBE_MAX_BITS = 36;
+static const std::size_t PROBE_BUCKETS = (PROBE_MAX_BITS - PROBE_SUB_BITS + 1) << PROBE_SUB_BITS;
+
+/* One thread's histograms and counters. Only the owner writes, so a relaxed load and
+   store is enough to count; readers see a slightly stale but never torn value. */
+struct ProbeThread
+{
+  std::atomic<uint64_t> buckets[PROBE_STAGES][PROBE_BUCKETS];
+  std::atomic<uint64_t> total[PROBE_STAGES]; // [ticks]
+  std::atomic<uint64_t> max[PROBE_STAGES];   // [ticks]
+  std::atomic<uint64_t> counters[COUNTER_COUNT];
+};
+
+inline std::size_t ProbeBucket(uint64_t ticks)
+{
+  if (ticks >> PROBE_MAX_BITS)
+    ticks = (uint64_t(1) << PROBE_MAX_BITS) - 1;
+  int msb = ticks ? 63 - __builtin_clzll(ticks) : 0;
+  int shift = msb > PROBE_SUB_BITS ? msb - PROBE_SUB_BITS : 0;
+  return (static_cast<std::size_t>(shift) << PROBE_SUB_BITS) + static_cast<std::size_t>(ticks >> shift);
+}
+
+/* Highest value [ticks] that falls in bucket i */
+inline uint64_t ProbeBucketValue(std::size_t i)
+{
+  std::size_t shift = i < (std::size_t(2) << PROBE_SUB_BITS) ? 0 : (i >> PROBE_SUB_BITS) - 1;
+  return ((uint64_t(i - (shift << PROBE_SUB_BITS)) + 1) << shift) - 1;
+}
+
+inline uint64_t ProbeClockNs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000u + uint64_t(ts.tv_nsec);
+}
+
+/* Raw counter, about half the cost of clock_gettime(): the TSC on x86 (constant rate on
+   anything recent), the generic timer on ARMv8, else CLOCK_MONOTONIC in ns */
+inline uint64_t ProbeNow()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t ticks;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+  return ProbeClockNs();
+#endif
+}
+
+/* Every thread that ever recorded; blocks outlive their threads so a dump still sees them.
+   The counter is calibrated against CLOCK_MONOTONIC from the first probe to the dump. */
+struct ProbeRegistry
+{
+  std::mutex lock;
+  std::vector<ProbeThread *> threads;
+  uint64_t startTicks;
+  uint64_t startNs;
+  ProbeRegistry() : startTicks(ProbeNow()), startNs(ProbeClockNs()) {}
+
+  double GetTicksPerNs() const
+  {
+    uint64_t ns = ProbeClockNs() - startNs;
+    return ns > 0 ? static_cast<double>(ProbeNow() - startTicks) / ns : 1.0;
+  }
+};
+
+inline ProbeRegistry &GetProbeRegistry()
+{
+  static ProbeRegistry registry;
+  return registry;
+}
+
+/* The calling thread's block, registered on first use (the only lock taken) */
+inline ProbeThread &GetProbeThread()
+{
+  static thread_local ProbeThread *local = nullptr;
+  if (local == nullptr)
+  {
+    local = new ProbeThread(); // Value-initialised: all zero
+    ProbeRegistry &registry = GetProbeRegistry();
+    std::lock_guard<std::mutex> hold(registry.lock);
+    registry.threads.push_back(local);
+  }
+  return *local;
+}
+
+inline void ProbeAdd(std::atomic<uint64_t> &value, uint64_t n)
+{
+  value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void ProbeRecord(int probe, uint64_t ticks)
+{
+  ProbeThread &t = GetProbeThread();
+  ProbeAdd(t.buckets[probe][ProbeBucket(ticks)], 1);
+  ProbeAdd(t.total[probe], ticks);
+  if (ticks > t.max[probe].load(std::memory_order_relaxed))
+    t.max[probe].store(ticks, std::memory_order_relaxed);
+}
+
+inline void ProbeCount(int counter, uint64_t n = 1)
+{
+  ProbeAdd(GetProbeThread().counters[counter], n);
+}
+
+/* Times its scope into a PROBE histogram */
+class ScopedProbe
+{
+public:
+  explicit ScopedProbe(int probe) : probe_(probe), start_(ProbeNow()) {}
+  ~ScopedProbe() { ProbeRecord(probe_, ProbeNow() - start_); }
+
+  ScopedProbe(const ScopedProbe &) = delete;
+  ScopedProbe &operator=(const ScopedProbe &) = delete;
+
+private:
+  int probe_;
+  uint64_t start_;
+};
+
+/**
+ * @brief: Probes compile to nothing unless the build defines PST_PROBES (cmake
+ *         -DPROBES=ON). PROBE_SCOPE(p) times the rest of the enclosing scope,
+ *         PROBE_COUNT(c, n) adds n to a counter. See ProbeReport for the dump.
+ */
+#define PROBE_CONCAT2(a, b) a##b
+#define PROBE_CONCAT(a, b) PROBE_CONCAT2(a, b)
+#ifdef PST_PROBES
+#define PROBE_SCOPE(probe) ScopedProbe PROBE_CONCAT(probe_, __LINE__)(probe)
+#define PROBE_COUNT(counter, n) ProbeCount(counter, n)
+#else
+#define PROBE_SCOPE(probe) ((void)0)
+#define PROBE_COUNT(counter, n) ((void)0)
+#endif
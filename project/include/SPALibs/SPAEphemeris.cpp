@@ -0,0 +1,44 @@
+#include "SPAEphemeris.h"
+#include <math.h>
+
+int SPAEphemeris::Build(const DateTimeData &start, double spanDays, double leadDays)
+{
+  nodes_.clear();
+
+  int result = engine_.GetJulianDay(start, &jd0_, &deltaT_);
+  if (result != 0)
+    return result;
+  jd0_ -= leadDays;
+
+  // Enough nodes for the span plus the quadratic's third point
+  std::size_t count = static_cast<std::size_t>(ceil((spanDays + leadDays) / SunNode::SPACING)) + 3;
+  nodes_.resize(count);
+  for (std::size_t k = 0; k < count; k++)
+  {
+    engine_.GetSunNode(jd0_ + k * SunNode::SPACING, deltaT_, &nodes_[k]);
+    if (k > 0)
+      nodes_[k].UnwrapAlpha(nodes_[k - 1]);
+  }
+  return 0;
+}
+
+void SPAEphemeris::GetSunPosition(double jd, SunPosition *out) const
+{
+  SunNode node;
+  GetSunNode(jd, &node);
+  engine_.GetTopocentric(jd, node, out);
+}
+
+void SPAEphemeris::GetSunNode(double jd, SunNode *out) const
+{
+  // Pick the three nodes that centre jd (t within [0.5, 1.5] away from the edges)
+  double u = (jd - jd0_) / SunNode::SPACING;
+  long k = static_cast<long>(floor(u + 0.5)) - 1;
+  long last = static_cast<long>(nodes_.size()) - 3;
+  if (k < 0)
+    k = 0;
+  if (k > last)
+    k = last;
+
+  *out = SunNode::Interpolate(nodes_[k], nodes_[k + 1], nodes_[k + 2], u - k);
+}
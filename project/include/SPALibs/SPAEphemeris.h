@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "SPALib.h"
+
+/**
+ * @brief: Geocentric sun terms on a SunNode grid over a time span, for random-access
+ *         evaluation. Building costs one full series per node; each GetSunPosition()
+ *         afterwards is an interpolation plus the exact topocentric stage.
+ */
+class SPAEphemeris
+{
+public:
+  explicit SPAEphemeris(const SPALib &engine) : engine_(engine), jd0_(0.0), deltaT_(0.0) {}
+
+  /**
+   * @brief: Build nodes covering [start - leadDays, start + spanDays]. Returns the
+   *         spa_calculate() error code for start, 0 on success.
+   */
+  int Build(const DateTimeData &start, double spanDays, double leadDays = 0.0);
+
+  double GetStartJd() const { return jd0_; }
+  double GetEndJd() const { return jd0_ + (nodes_.size() - 1) * SunNode::SPACING; }
+  bool IsEmpty() const { return nodes_.size() < 3; }
+
+  /**
+   * @brief: Sun position at jd (UT). Outside the built span the nearest nodes are
+   *         extrapolated, so accuracy degrades there.
+   */
+  void GetSunPosition(double jd, SunPosition *out) const;
+
+  /**
+   * @brief: Interpolated geocentric terms at jd (UT), same extrapolation caveat.
+   */
+  void GetSunNode(double jd, SunNode *out) const;
+
+private:
+  const SPALib &engine_;
+  std::vector<SunNode> nodes_;
+  double jd0_;
+  double deltaT_;
+};
@@ -0,0 +1,209 @@
+#include "SPAField.h"
+#include <algorithm>
+#include <math.h>
+
+namespace
+{
+  /* Overlap area of two circles with radii a, b and centres d apart */
+  double LensArea(double a, double b, double d)
+  {
+    if (d >= a + b)
+      return 0.0;
+    if (d <= fabs(a - b))
+    {
+      double r = fmin(a, b);
+      return M_PI * r * r;
+    }
+    double ca = (d * d + a * a - b * b) / (2.0 * d * a);
+    double cb = (d * d + b * b - a * a) / (2.0 * d * b);
+    double k = (-d + a + b) * (d + a - b) * (d - a + b) * (d + a + b);
+    return a * a * acos(ca) + b * b * acos(cb) - 0.5 * sqrt(fmax(k, 0.0));
+  }
+}
+
+SPAField::SPAField(const std::vector<FieldDish> &dishes, const FieldConfig &config)
+    : dishes_(dishes), config_(config), minEast_(0.0), minNorth_(0.0), cell_(1.0),
+      columns_(1), rows_(1), maxRadius_(0.0), heightSpan_(0.0)
+{
+  double maxEast = 0.0, maxNorth = 0.0, minUp = 0.0, maxUp = 0.0;
+  for (std::size_t i = 0; i < dishes_.size(); i++)
+  {
+    const FieldDish &d = dishes_[i];
+    if (i == 0 || d.east < minEast_)
+      minEast_ = d.east;
+    if (i == 0 || d.north < minNorth_)
+      minNorth_ = d.north;
+    if (i == 0 || d.east > maxEast)
+      maxEast = d.east;
+    if (i == 0 || d.north > maxNorth)
+      maxNorth = d.north;
+    if (i == 0 || d.up < minUp)
+      minUp = d.up;
+    if (i == 0 || d.up > maxUp)
+      maxUp = d.up;
+    maxRadius_ = fmax(maxRadius_, 0.5 * d.aperture);
+  }
+  heightSpan_ = maxUp - minUp;
+
+  // One aperture per cell: a shadow corridor is then only three cells wide
+  if (maxRadius_ > 0.0)
+    cell_ = 2.0 * maxRadius_;
+  columns_ = static_cast<long>(floor((maxEast - minEast_) / cell_)) + 1;
+  rows_ = static_cast<long>(floor((maxNorth - minNorth_) / cell_)) + 1;
+
+  // Counting sort of the dishes into their cells
+  std::vector<std::size_t> cellOf(dishes_.size());
+  cellStart_.assign(columns_ * rows_ + 1, 0);
+  for (std::size_t i = 0; i < dishes_.size(); i++)
+  {
+    long c = static_cast<long>((dishes_[i].east - minEast_) / cell_);
+    long r = static_cast<long>((dishes_[i].north - minNorth_) / cell_);
+    cellOf[i] = r * columns_ + c;
+    cellStart_[cellOf[i] + 1]++;
+  }
+  for (std::size_t c = 1; c < cellStart_.size(); c++)
+    cellStart_[c] += cellStart_[c - 1];
+  cellItems_.resize(dishes_.size());
+  std::vector<std::size_t> fill(cellStart_.begin(), cellStart_.end() - 1);
+  for (std::size_t i = 0; i < dishes_.size(); i++)
+    cellItems_[fill[cellOf[i]]++] = i;
+
+  order_.resize(dishes_.size());
+  along_.resize(dishes_.size());
+}
+
+void SPAField::Update(const SunPosition &sun, std::vector<DishState> *out)
+{
+  const std::size_t n = dishes_.size();
+  out->resize(n);
+  stats_ = FieldStats();
+  stats_.dishes = n;
+
+  // Below the horizon every dish lies flat
+  const double elevation = 90.0 - sun.zenith;
+  if (elevation <= 0.0)
+  {
+    for (std::size_t i = 0; i < n; i++)
+    {
+      DishState &st = (*out)[i];
+      st.shaded = 1.0;
+      st.tracking = false;
+      st.target.zenith = 0.0;
+      st.target.azimuth = sun.azimuth;
+      st.target.incidence = sun.zenith;
+    }
+    stats_.flat = n;
+    return;
+  }
+
+  // Unit vector toward the sun: east, north, up
+  const double zenith = deg2rad(sun.zenith), azimuth = deg2rad(sun.azimuth);
+  const double s[3] = {sin(zenith) * sin(azimuth), sin(zenith) * cos(azimuth), cos(zenith)};
+  const double sinElevation = s[2];
+
+  // Settle dishes from the sun side backwards, so every shader is decided first
+  for (std::size_t i = 0; i < n; i++)
+  {
+    order_[i] = i;
+    along_[i] = dishes_[i].east * s[0] + dishes_[i].north * s[1] + dishes_[i].up * s[2];
+  }
+  std::sort(order_.begin(), order_.end(),
+            [this](std::size_t a, std::size_t b) { return along_[a] > along_[b]; });
+
+  // Horizontal distance beyond which no disc can reach another's sun ray
+  const double reach = fmin(config_.maxReach, (2.0 * maxRadius_ + heightSpan_) / sinElevation);
+
+  for (std::size_t k = 0; k < n; k++)
+  {
+    std::size_t i = order_[k];
+    DishState &st = (*out)[i];
+    Shade(i, s, sinElevation, reach, *out, &st.shaded);
+
+    st.tracking = st.shaded <= config_.maxShade;
+    if (st.tracking)
+    {
+      st.target = sun;
+      st.target.incidence = 0.0;
+    }
+    else
+    {
+      st.target.zenith = 0.0;
+      st.target.azimuth = sun.azimuth;
+      st.target.incidence = sun.zenith;
+      stats_.flat++;
+    }
+    if (st.shaded > 0.0)
+      stats_.shaded++;
+  }
+}
+
+void SPAField::Shade(std::size_t i, const double s[3], double sinElevation, double reach,
+                     const std::vector<DishState> &states, double *shaded)
+{
+  const FieldDish &di = dishes_[i];
+  const double ri = 0.5 * di.aperture;
+  *shaded = 0.0;
+  if (ri <= 0.0)
+    return;
+
+  // Shadow corridor: from the dish toward the sun's azimuth, one aperture either side
+  double horizontal = hypot(s[0], s[1]);
+  double dx = horizontal > 0.0 ? s[0] / horizontal * reach : 0.0;
+  double dy = horizontal > 0.0 ? s[1] / horizontal * reach : 0.0;
+  double width = 2.0 * maxRadius_;
+
+  long r0 = static_cast<long>(floor((fmin(di.north, di.north + dy) - width - minNorth_) / cell_));
+  long r1 = static_cast<long>(floor((fmax(di.north, di.north + dy) + width - minNorth_) / cell_));
+  r0 = std::max(r0, 0L);
+  r1 = std::min(r1, rows_ - 1);
+
+  // Flat dishes cast an ellipse of sin(elevation) height: use the equal-area disc
+  const double flatScale = sqrt(sinElevation);
+  double area = 0.0;
+  for (long r = r0; r <= r1; r++)
+  {
+    // Part of the segment within `width` of this row of cells, then its east extent
+    double y0 = minNorth_ + r * cell_ - width - di.north;
+    double y1 = y0 + cell_ + 2.0 * width;
+    double t0 = 0.0, t1 = 1.0;
+    if (fabs(dy) > 1e-12)
+    {
+      t0 = fmax(0.0, fmin(y0 / dy, y1 / dy));
+      t1 = fmin(1.0, fmax(y0 / dy, y1 / dy));
+      if (t0 > t1)
+        continue;
+    }
+    else if (y0 > 0.0 || y1 < 0.0)
+      continue;
+
+    double x0 = di.east + fmin(t0 * dx, t1 * dx) - width - minEast_;
+    double x1 = di.east + fmax(t0 * dx, t1 * dx) + width - minEast_;
+    long c0 = std::max(static_cast<long>(floor(x0 / cell_)), 0L);
+    long c1 = std::min(static_cast<long>(floor(x1 / cell_)), columns_ - 1);
+
+    for (long c = c0; c <= c1; c++)
+    {
+      std::size_t cell = r * columns_ + c;
+      for (std::size_t m = cellStart_[cell]; m < cellStart_[cell + 1]; m++)
+      {
+        std::size_t j = cellItems_[m];
+        const FieldDish &dj = dishes_[j];
+        double d[3] = {dj.east - di.east, dj.north - di.north, dj.up - di.up};
+        double along = d[0] * s[0] + d[1] * s[1] + d[2] * s[2];
+        if (j == i || along <= 0.0)
+          continue;
+
+        stats_.candidates++;
+        double rj = 0.5 * dj.aperture * (states[j].tracking ? 1.0 : flatScale);
+        double q2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2] - along * along;
+        if (q2 >= (ri + rj) * (ri + rj))
+          continue;
+
+        area += LensArea(ri, rj, sqrt(fmax(q2, 0.0)));
+      }
+    }
+  }
+
+  // Shadows of different dishes are summed: overlapping shadows count twice
+  *shaded = fmin(1.0, area / (M_PI * ri * ri));
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "SPALib.h"
+
+/*************************** USER INPUT DATA ***************************************/
+struct FieldDish
+{
+  double east;     // Pivot position east of the field origin [m]
+  double north;    // Pivot position north of the field origin [m]
+  double up;       // Pivot height above the field origin [m]
+  double aperture; // Aperture diameter [m]
+  FieldDish(const double &e, const double &n, const double &u, const double &a)
+      : east(e), north(n), up(u), aperture(a) {}
+};
+
+struct FieldConfig
+{
+  double maxShade; // Shaded fraction above which a dish gives up and lies flat [0..1]
+  double maxReach; // Longest shadow considered, caps the search at low sun [m]
+  FieldConfig(const double &s = 0.5, const double &r = 250.0) : maxShade(s), maxReach(r) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+struct DishState
+{
+  double shaded;      // Fraction of the aperture in the shadow of dishes in front [0..1]
+  bool tracking;      // False when the dish is laid flat (shaded past maxShade, or night)
+  SunPosition target; // Shade-aware pointing; incidence is the resulting sun incidence
+};
+
+struct FieldStats
+{
+  std::size_t dishes;     // Dishes evaluated in the last Update()
+  std::size_t candidates; // Neighbours ahead of a dish tested after the grid lookup
+  std::size_t shaded;     // Dishes with any shade
+  std::size_t flat;       // Dishes laid flat
+  FieldStats() : dishes(0), candidates(0), shaded(0), flat(0) {}
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/**
+ * @brief: Mutual shading of a field of two-axis dishes. A tracking aperture is a disc
+ *         facing the sun, so in the plane normal to the sun vector every dish is a
+ *         circle and shading is circle overlap with the dishes ahead of it. Dishes are
+ *         binned once in a uniform ground grid with one aperture per cell; each tick a
+ *         dish only visits the cells along the corridor its shadow can come from.
+ *
+ *         Dishes are settled from the sun side backwards. One shaded past maxShade is
+ *         laid flat (face up) instead of tracking: its own shadow on the rows behind
+ *         then shrinks to sin(elevation) of the disc, so the rows behind recover.
+ */
+class SPAField
+{
+public:
+  SPAField(const std::vector<FieldDish> &dishes, const FieldConfig &config = FieldConfig());
+
+  /**
+   * @brief: Shading and targets for the apparent sun position (from the field's
+   *         SPALib engine). out is resized to one entry per dish, in input order.
+   */
+  void Update(const SunPosition &sun, std::vector<DishState> *out);
+
+  const FieldStats &GetStats() const { return stats_; }
+  std::size_t GetDishCount() const { return dishes_.size(); }
+
+private:
+  void Shade(std::size_t i, const double s[3], double sinElevation, double reach,
+             const std::vector<DishState> &states, double *shaded);
+
+  std::vector<FieldDish> dishes_;
+  FieldConfig config_;
+  FieldStats stats_;
+
+  // Uniform grid over the ground plane, dish indices bucketed per cell (CSR layout)
+  double minEast_;
+  double minNorth_;
+  double cell_;
+  long columns_;
+  long rows_;
+  std::vector<std::size_t> cellStart_;
+  std::vector<std::size_t> cellItems_;
+
+  double maxRadius_;
+  double heightSpan_;
+  std::vector<std::size_t> order_;
+  std::vector<double> along_;
+};
@@ -0,0 +1,98 @@
+#include "SPAHeliostat.h"
+#include <math.h>
+
+namespace
+{
+  /* Unit bisectors of the sun vector s and the unit receiver vectors rx, and the cosine
+     of the incidence angle. Plain arithmetic over non-aliased arrays, so it vectorises. */
+  void Bisect(std::size_t n, double se, double sn, double su, const double *__restrict rxE,
+              const double *__restrict rxN, const double *__restrict rxU, double *__restrict ne,
+              double *__restrict nn, double *__restrict nu, double *__restrict cosInc)
+  {
+    for (std::size_t i = 0; i < n; i++)
+    {
+      double x = se + rxE[i];
+      double y = sn + rxN[i];
+      double z = su + rxU[i];
+      double inv = 1.0 / sqrt(x * x + y * y + z * z + 1e-30); // Bias: receiver opposite the sun
+      ne[i] = x * inv;
+      nn[i] = y * inv;
+      nu[i] = z * inv;
+      cosInc[i] = (se * x + sn * y + su * z) * inv;
+    }
+  }
+}
+
+SPAHeliostat::SPAHeliostat(const std::vector<HeliostatMirror> &mirrors,
+                           const std::vector<ReceiverPoint> &receivers)
+    : receivers_(receivers)
+{
+  const std::size_t n = mirrors.size();
+  east_.resize(n);
+  north_.resize(n);
+  up_.resize(n);
+  rxEast_.assign(n, 0.0);
+  rxNorth_.assign(n, 0.0);
+  rxUp_.assign(n, 0.0);
+  for (std::size_t i = 0; i < n; i++)
+  {
+    east_[i] = mirrors[i].east;
+    north_[i] = mirrors[i].north;
+    up_[i] = mirrors[i].up;
+    Compile(i, mirrors[i].receiver);
+  }
+}
+
+void SPAHeliostat::SetReceiver(std::size_t mirror, std::size_t receiver)
+{
+  if (mirror < east_.size())
+    Compile(mirror, receiver);
+}
+
+void SPAHeliostat::Compile(std::size_t mirror, std::size_t receiver)
+{
+  if (receiver >= receivers_.size())
+    return;
+
+  const ReceiverPoint &rx = receivers_[receiver];
+  double de = rx.east - east_[mirror];
+  double dn = rx.north - north_[mirror];
+  double du = rx.up - up_[mirror];
+  double length = sqrt(de * de + dn * dn + du * du);
+
+  // A mirror sitting on its receiver point degenerates to plain sun tracking
+  double inv = length > 0.0 ? 1.0 / length : 0.0;
+  rxEast_[mirror] = de * inv;
+  rxNorth_[mirror] = dn * inv;
+  rxUp_[mirror] = du * inv;
+}
+
+void SPAHeliostat::Update(const SunPosition &sun, AimBatch *out) const
+{
+  const std::size_t n = east_.size();
+  out->normalEast.resize(n);
+  out->normalNorth.resize(n);
+  out->normalUp.resize(n);
+  out->azimuth.resize(n);
+  out->elevation.resize(n);
+  out->incidence.resize(n);
+
+  // The one sun vector of this tick: east, north, up
+  const double zenith = deg2rad(sun.zenith), azimuth = deg2rad(sun.azimuth);
+  const double se = sin(zenith) * sin(azimuth);
+  const double sn = sin(zenith) * cos(azimuth);
+  const double su = cos(zenith);
+
+  // incidence holds the cosine until the angle pass below
+  Bisect(n, se, sn, su, rxEast_.data(), rxNorth_.data(), rxUp_.data(), out->normalEast.data(),
+         out->normalNorth.data(), out->normalUp.data(), out->incidence.data());
+
+  // Angles for the drives
+  for (std::size_t i = 0; i < n; i++)
+  {
+    double a = rad2deg(atan2(out->normalEast[i], out->normalNorth[i]));
+    out->azimuth[i] = a < 0.0 ? a + 360.0 : a;
+    out->elevation[i] = rad2deg(asin(fmax(-1.0, fmin(1.0, out->normalUp[i]))));
+    out->incidence[i] = rad2deg(acos(fmax(-1.0, fmin(1.0, out->incidence[i]))));
+  }
+}
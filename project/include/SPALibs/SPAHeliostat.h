@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "SPALib.h"
+
+/*************************** USER INPUT DATA ***************************************/
+struct HeliostatMirror
+{
+  double east;          // Mirror pivot east of the field origin [m]
+  double north;         // Mirror pivot north of the field origin [m]
+  double up;            // Mirror pivot height above the field origin [m]
+  std::size_t receiver; // Index of the receiver point this mirror feeds
+  HeliostatMirror(const double &e, const double &n, const double &u, const std::size_t &r = 0)
+      : east(e), north(n), up(u), receiver(r) {}
+};
+
+struct ReceiverPoint
+{
+  double east;  // Aim point east of the field origin [m]
+  double north; // Aim point north of the field origin [m]
+  double up;    // Aim point height above the field origin [m]
+  ReceiverPoint(const double &e, const double &n, const double &u) : east(e), north(n), up(u) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+/* One entry per mirror in every array (structure of arrays) */
+struct AimBatch
+{
+  std::vector<double> normalEast;  // Mirror normal, unit vector east component
+  std::vector<double> normalNorth; // Mirror normal, north component
+  std::vector<double> normalUp;    // Mirror normal, up component
+  std::vector<double> azimuth;     // Normal azimuth, eastward from north [degrees]
+  std::vector<double> elevation;   // Normal elevation above the horizon [degrees]
+  std::vector<double> incidence;   // Sun incidence angle on the mirror [degrees]
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/**
+ * @brief: Batch aim vectors for mirrors that redirect the sun onto a fixed receiver.
+ *         A mirror's normal is the bisector of the sun vector and its mirror-to-receiver
+ *         vector. The latter only changes when the field does, so it is stored
+ *         normalised per mirror; each tick then turns one sun vector into all normals
+ *         in a single pass over contiguous arrays that the compiler can vectorise.
+ */
+class SPAHeliostat
+{
+public:
+  SPAHeliostat(const std::vector<HeliostatMirror> &mirrors,
+               const std::vector<ReceiverPoint> &receivers);
+
+  /* Re-point one mirror at another receiver (receiver out of range is ignored) */
+  void SetReceiver(std::size_t mirror, std::size_t receiver);
+
+  /**
+   * @brief: Aim every mirror for the apparent sun position (from the field's SPALib
+   *         engine). out arrays are resized to one entry per mirror.
+   */
+  void Update(const SunPosition &sun, AimBatch *out) const;
+
+  std::size_t GetMirrorCount() const { return east_.size(); }
+
+private:
+  void Compile(std::size_t mirror, std::size_t receiver);
+
+  std::vector<ReceiverPoint> receivers_;
+  std::vector<double> east_;
+  std::vector<double> north_;
+  std::vector<double> up_;
+  std::vector<double> rxEast_;  // Unit mirror-to-receiver vector, zero if coincident
+  std::vector<double> rxNorth_;
+  std::vector<double> rxUp_;
+};
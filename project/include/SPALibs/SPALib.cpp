@@ -1 +1,506 @@
-#include "SPALib.h"
\ No newline at end of file
+#include "SPALib.h"
+#include <math.h>
+#include "Probe.h"
+
+/**
+ *
+ * @name: SPALib
+ * @brief: C++ front-end over NREL's spa.c. Builds the spa_data input from the tracker's
+ *          site, date/time and weather types and adds a time-series generator for
+ *          evaluating whole trajectories (motor planning, dashboard daily arc).
+ */
+
+constexpr double SunNode::SPACING;
+
+namespace
+{
+  /* Sun radius used by spa.c to gate the refraction correction [degrees] */
+  const double SUN_RADIUS = 0.26667;
+
+  /* Value with its first and second time derivative, for the analytic rates */
+  struct Jet
+  {
+    double v, d, dd;
+    Jet(double value, double d1 = 0.0, double d2 = 0.0) : v(value), d(d1), dd(d2) {}
+  };
+
+  Jet operator+(const Jet &a, const Jet &b) { return Jet(a.v + b.v, a.d + b.d, a.dd + b.dd); }
+  Jet operator-(const Jet &a, const Jet &b) { return Jet(a.v - b.v, a.d - b.d, a.dd - b.dd); }
+  Jet operator*(const Jet &a, const Jet &b)
+  {
+    return Jet(a.v * b.v, a.d * b.v + a.v * b.d, a.dd * b.v + 2.0 * a.d * b.d + a.v * b.dd);
+  }
+  Jet operator/(const Jet &a, const Jet &b)
+  {
+    double q = a.v / b.v;
+    double qd = (a.d - q * b.d) / b.v;
+    return Jet(q, qd, (a.dd - 2.0 * qd * b.d - q * b.dd) / b.v);
+  }
+  Jet Sin(const Jet &x)
+  {
+    double s = sin(x.v), c = cos(x.v);
+    return Jet(s, c * x.d, c * x.dd - s * x.d * x.d);
+  }
+  Jet Cos(const Jet &x)
+  {
+    double s = sin(x.v), c = cos(x.v);
+    return Jet(c, -s * x.d, -s * x.dd - c * x.d * x.d);
+  }
+  Jet Asin(const Jet &x)
+  {
+    double k = 1.0 / sqrt(1.0 - x.v * x.v);
+    return Jet(asin(x.v), k * x.d, k * x.dd + x.v * k * k * k * x.d * x.d);
+  }
+  Jet Atan2(const Jet &y, const Jet &x)
+  {
+    Jet num = x * Jet(y.d, y.dd) - y * Jet(x.d, x.dd);
+    Jet den = x * x + y * y;
+    Jet rate = num / den;
+    return Jet(atan2(y.v, x.v), rate.v, rate.d);
+  }
+
+  /* Geocentric terms from the PSA algorithm (Blanco-Muriel et al., Solar Energy 70, 2001) */
+  void PsaSunNode(double jd, SunNode *node)
+  {
+    double n = jd - 2451545.0;
+    double omega = 2.1429 - 0.0010394594 * n;
+    double meanLongitude = 4.8950630 + 0.017202791698 * n;
+    double meanAnomaly = 6.2400600 + 0.0172019699 * n;
+    double nutation = -0.0000203 * sin(omega);
+    double lamda = meanLongitude + 0.03341607 * sin(meanAnomaly) +
+                   0.00034894 * sin(2.0 * meanAnomaly) - 0.0001134 + nutation;
+    double epsilon = 0.4090928 - 6.2140e-9 * n + 0.0000396 * cos(omega);
+
+    node->alpha = limit_degrees(rad2deg(atan2(cos(epsilon) * sin(lamda), cos(lamda))));
+    node->delta = rad2deg(asin(sin(epsilon) * sin(lamda)));
+    node->xi = sun_equatorial_horizontal_parallax(1.0);
+    // PSA's longitude includes the nutation term, so pair it with apparent sidereal time
+    node->eqeq = rad2deg(nutation) * cos(epsilon);
+  }
+}
+
+void SunNode::UnwrapAlpha(const SunNode &prev)
+{
+  while (alpha - prev.alpha > 180.0)
+    alpha -= 360.0;
+  while (alpha - prev.alpha < -180.0)
+    alpha += 360.0;
+}
+
+SunNode SunNode::Interpolate(const SunNode &n0, const SunNode &n1, const SunNode &n2, double t)
+{
+  auto quadratic = [t](double f0, double f1, double f2) -> double
+  {
+    double a = f1 - f0;
+    double b = f2 - f1;
+    return f0 + t * (a + (b - a) * (t - 1.0) / 2.0);
+  };
+
+  SunNode node;
+  node.alpha = quadratic(n0.alpha, n1.alpha, n2.alpha);
+  node.delta = quadratic(n0.delta, n1.delta, n2.delta);
+  node.xi = quadratic(n0.xi, n1.xi, n2.xi);
+  node.eqeq = quadratic(n0.eqeq, n1.eqeq, n2.eqeq);
+  return node;
+}
+
+void SPALib::FillSpaInput(const DateTimeData &dt, int function, spa_data *spa) const
+{
+  spa->year = dt.dt.year;
+  spa->month = dt.dt.month;
+  spa->day = dt.dt.date;
+  spa->hour = dt.tt.hour;
+  spa->minute = dt.tt.minute;
+  spa->second = dt.tt.second;
+  spa->timezone = dt.tt.timezone;
+  TimeScaleData scale = timeScale_->Get(dt);
+  spa->delta_ut1 = scale.dut1;
+  spa->delta_t = scale.deltaT;
+  spa->function = function;
+  FillSiteInput(spa);
+}
+
+void SPALib::FillSiteInput(spa_data *spa) const
+{
+  spa->longitude = site_.pos.Longitude;
+  spa->latitude = site_.pos.Latitude;
+  spa->elevation = site_.pos.Altitude * 1000.0; // km -> m
+  spa->pressure = site_.weather.presure;
+  spa->temperature = site_.weather.temp;
+  spa->slope = site_.slope;
+  spa->azm_rotation = site_.azmRotation;
+  spa->atmos_refract = site_.atmosRefract;
+}
+
+SunData SPALib::GetSunPosition(const DateTimeData &dt) const
+{
+  PROBE_SCOPE(PROBE_SPA);
+  SunData sun;
+
+  double jd, deltaT;
+  SunNode node;
+
+  sun.errCode = GetJulianDay(dt, &jd, &deltaT);
+  if (sun.errCode == 0)
+  {
+    GetSunNode(jd, deltaT, &node);
+    GetTopocentric(jd, node, &sun.pos);
+  }
+  return sun;
+}
+
+SunData SPALib::GetSunPosition(double jdUtc) const
+{
+  PROBE_SCOPE(PROBE_SPA);
+  SunData sun;
+
+  double jd, deltaT;
+  SunNode node;
+
+  sun.errCode = GetJulianDayUtc(jdUtc, &jd, &deltaT);
+  if (sun.errCode == 0)
+  {
+    GetSunNode(jd, deltaT, &node);
+    GetTopocentric(jd, node, &sun.pos);
+  }
+  return sun;
+}
+
+int SPALib::GetJulianDayUtc(double jdUtc, double *jd, double *deltaT) const
+{
+  // The site is checked with a placeholder date, the date range on jdUtc itself
+  spa_data spa;
+  FillSiteInput(&spa);
+  spa.year = 2000;
+  spa.month = 1;
+  spa.day = 1;
+  spa.hour = 12;
+  spa.minute = 0;
+  spa.second = 0;
+  spa.timezone = 0;
+  spa.delta_ut1 = 0;
+  spa.delta_t = 0;
+  spa.function = SPA_ZA_INC;
+
+  int result = validate_inputs(&spa);
+  if (result != 0)
+    return result;
+
+  static const double first = julian_day(-2000, 1, 1, 0, 0, 0, 0, 0);
+  static const double last = julian_day(6001, 1, 1, 0, 0, 0, 0, 0);
+  if (jdUtc < first || jdUtc >= last)
+    return 1; // validate_inputs()'s code for a year outside -2000..6000
+
+  TimeScaleData scale = timeScale_->GetForJd(jdUtc);
+  *jd = jdUtc + scale.dut1 / 86400.0;
+  *deltaT = scale.deltaT;
+  return 0;
+}
+
+int SPALib::GetJulianDay(const DateTimeData &dt, double *jd, double *deltaT) const
+{
+  spa_data spa;
+  FillSpaInput(dt, SPA_ZA_INC, &spa);
+
+  int result = validate_inputs(&spa);
+  if (result == 0)
+  {
+    *jd = julian_day(spa.year, spa.month, spa.day, spa.hour, spa.minute, spa.second,
+                     spa.delta_ut1, spa.timezone);
+    *deltaT = spa.delta_t;
+  }
+  return result;
+}
+
+void SPALib::GetSunNode(double jd, double deltaT, SunNode *node) const
+{
+  if (tier_ == SPA_TIER_PSA)
+  {
+    PsaSunNode(jd, node);
+    return;
+  }
+
+  spa_data spa;
+  spa.jd = jd;
+  spa.delta_t = deltaT;
+  if (tier_ == SPA_TIER_TRUNCATED)
+    calculate_geocentric_sun_right_ascension_and_declination_truncated(&spa);
+  else
+    calculate_geocentric_sun_right_ascension_and_declination(&spa);
+
+  node->alpha = spa.alpha;
+  node->delta = spa.delta;
+  node->xi = sun_equatorial_horizontal_parallax(spa.r);
+  node->eqeq = spa.nu - spa.nu0;
+}
+
+void SPALib::Compile()
+{
+  double lat = deg2rad(site_.pos.Latitude);
+  double elevation = site_.pos.Altitude * 1000.0; // km -> m
+  double u = atan(0.99664719 * tan(lat));
+
+  k_.sinLat = sin(lat);
+  k_.cosLat = cos(lat);
+  k_.sinLon = sin(deg2rad(site_.pos.Longitude));
+  k_.cosLon = cos(deg2rad(site_.pos.Longitude));
+  k_.obsX = cos(u) + elevation * k_.cosLat / 6378140.0;
+  k_.obsY = 0.99664719 * sin(u) + elevation * k_.sinLat / 6378140.0;
+  k_.refractLimit = -1 * (SUN_RADIUS + site_.atmosRefract);
+
+  // azm_rotation is measured from south, so the normal points at azimuth azm_rotation + 180
+  double slope = deg2rad(site_.slope);
+  double normalAzimuth = deg2rad(site_.azmRotation + 180.0);
+  k_.cosSlope = cos(slope);
+  k_.normalN = sin(slope) * cos(normalAzimuth);
+  k_.normalE = sin(slope) * sin(normalAzimuth);
+
+  CompileWeather();
+}
+
+void SPALib::CompileWeather()
+{
+  k_.refractScale = (site_.weather.presure / 1010.0) * (283.0 / (273.0 + site_.weather.temp)) *
+                    1.02 / 60.0;
+}
+
+bool SPALib::UpdateWeather(const IWeather &weather)
+{
+  return SetWeather(weather.GetWeatherData());
+}
+
+bool SPALib::SetWeather(const WeatherData &w)
+{
+  if (w.temp == site_.weather.temp && w.presure == site_.weather.presure)
+  {
+    site_.weather.humidity = w.humidity;
+    return false;
+  }
+
+  site_.weather = w;
+  CompileWeather();
+  return true;
+}
+
+void SPALib::GetSunVector(double jd, const SunNode &node, SunVector *out)
+{
+  double nu = greenwich_mean_sidereal_time(jd, julian_century(jd)) + node.eqeq;
+  double gha = deg2rad(nu - node.alpha);
+  double delta = deg2rad(node.delta);
+  double distance = 1.0 / sin(deg2rad(node.xi)); // Sun distance [earth radii]
+
+  double cosDelta = cos(delta);
+  out->x = distance * cosDelta * cos(gha);
+  out->y = distance * cosDelta * sin(gha);
+  out->z = distance * sin(delta);
+}
+
+double SPALib::GetElevationSine(const SunVector &v) const
+{
+  double tx = v.x * k_.cosLon - v.y * k_.sinLon - k_.obsX;
+  double ty = v.y * k_.cosLon + v.x * k_.sinLon;
+  double tz = v.z - k_.obsY;
+  return (k_.cosLat * tx + k_.sinLat * tz) / sqrt(tx * tx + ty * ty + tz * tz);
+}
+
+void SPALib::GetTopocentric(double jd, const SunNode &node, SunPosition *out) const
+{
+  SunVector v;
+  GetSunVector(jd, node, &v);
+  GetTopocentric(v, out);
+}
+
+double SPALib::Horizon(const SunVector &v, double *north, double *east, double *cosInc) const
+{
+  // Rotate to the local hour-angle frame and move the origin to the observer
+  double tx = v.x * k_.cosLon - v.y * k_.sinLon - k_.obsX;
+  double ty = v.y * k_.cosLon + v.x * k_.sinLon;
+  double tz = v.z - k_.obsY;
+
+  // Local horizon frame
+  double up = k_.cosLat * tx + k_.sinLat * tz;
+  *north = k_.cosLat * tz - k_.sinLat * tx;
+  *east = -ty;
+  double horizontal = sqrt(*north * *north + *east * *east);
+
+  double e0 = rad2deg(atan2(up, horizontal));
+  double e = e0;
+  if (e0 >= k_.refractLimit)
+    e += k_.refractScale / tan(deg2rad(e0 + 10.3 / (e0 + 5.11)));
+
+  double eRad = deg2rad(e);
+  *cosInc = sin(eRad) * k_.cosSlope;
+  if (horizontal > 0.0)
+    *cosInc += cos(eRad) * (*north * k_.normalN + *east * k_.normalE) / horizontal;
+  *cosInc = fmax(-1.0, fmin(1.0, *cosInc));
+  return e;
+}
+
+void SPALib::GetTopocentric(const SunVector &v, SunPosition *out) const
+{
+  double north, east, cosInc;
+  double e = Horizon(v, &north, &east, &cosInc);
+
+  out->zenith = topocentric_zenith_angle(e);
+  out->azimuth = limit_degrees(rad2deg(atan2(east, north)));
+  out->incidence = rad2deg(acos(cosInc));
+}
+
+double SPALib::GetElevation(const SunVector &v, double *cosIncidence) const
+{
+  double north, east;
+  return Horizon(v, &north, &east, cosIncidence);
+}
+
+int SPALib::GetSunSeries(const DateTimeData &start, double step, std::size_t count,
+                         SunPosition *out) const
+{
+  if (!out || step <= 0.0)
+    return -1;
+  if (count == 0)
+    return 0;
+
+  double jd0, deltaT;
+  int result = GetJulianDay(start, &jd0, &deltaT);
+  if (result != 0)
+    return result;
+
+  const double stepDays = step / 86400.0;
+  SunNode node[3];
+
+  // Steps coarser than the node grid gain nothing from interpolation
+  if (stepDays >= SunNode::SPACING)
+  {
+    for (std::size_t i = 0; i < count; i++)
+    {
+      double jd = jd0 + i * stepDays;
+      GetSunNode(jd, deltaT, &node[0]);
+      GetTopocentric(jd, node[0], &out[i]);
+    }
+    return 0;
+  }
+
+  double jdA = jd0;
+  for (int k = 0; k < 3; k++)
+  {
+    GetSunNode(jdA + k * SunNode::SPACING, deltaT, &node[k]);
+    if (k > 0)
+      node[k].UnwrapAlpha(node[k - 1]);
+  }
+
+  for (std::size_t i = 0; i < count; i++)
+  {
+    double jd = jd0 + i * stepDays;
+    while (jd >= jdA + SunNode::SPACING)
+    {
+      node[0] = node[1];
+      node[1] = node[2];
+      jdA += SunNode::SPACING;
+      GetSunNode(jdA + 2.0 * SunNode::SPACING, deltaT, &node[2]);
+      node[2].UnwrapAlpha(node[1]);
+    }
+
+    double t = (jd - jdA) / SunNode::SPACING;
+    GetTopocentric(jd, SunNode::Interpolate(node[0], node[1], node[2], t), &out[i]);
+  }
+  return 0;
+}
+
+RtsData SPALib::GetRiseTransitSet(const DateTimeData &dt) const
+{
+  RtsData rts;
+  spa_data spa;
+
+  FillSpaInput(dt, SPA_ZA_RTS, &spa);
+  rts.errCode = spa_calculate(&spa);
+  if (rts.errCode == 0)
+  {
+    rts.jd = spa.jd;
+    rts.suntransit = spa.suntransit;
+    rts.sunrise = spa.sunrise;
+    rts.sunset = spa.sunset;
+    rts.srha = spa.srha;
+    rts.ssha = spa.ssha;
+    rts.sta = spa.sta;
+    rts.eot = spa.eot;
+  }
+  return rts;
+}
+
+SunRates SPALib::GetSunRates(const DateTimeData &dt) const
+{
+  SunRates rates;
+
+  double jd, deltaT;
+  SunNode node;
+  SunVector v;
+
+  // Same stages as GetSunPosition(), so the tier and the compiled site apply to both
+  rates.errCode = GetJulianDay(dt, &jd, &deltaT);
+  if (rates.errCode != 0)
+    return rates;
+  GetSunNode(jd, deltaT, &node);
+  GetSunVector(jd, node, &v);
+  GetTopocentric(v, &rates.pos);
+
+  // Topocentric hour angle and declination from the observer's hour-angle frame
+  double tx = v.x * k_.cosLon - v.y * k_.sinLon - k_.obsX;
+  double ty = v.y * k_.cosLon + v.x * k_.sinLon;
+  double tz = v.z - k_.obsY;
+  double hPrime = atan2(ty, tx);
+  double deltaPrime = atan2(tz, sqrt(tx * tx + ty * ty));
+
+  // Apparent longitude back from the node, on the mean obliquity [rad]
+  double t = julian_century(jd);
+  double epsilon = deg2rad(23.439291 - 0.0130042 * t);
+  double alpha0 = deg2rad(node.alpha), delta0 = deg2rad(node.delta);
+  double lamda0 = atan2(sin(alpha0) * cos(epsilon) + tan(delta0) * sin(epsilon), cos(alpha0));
+
+  // Apparent longitude rate from the mean motion and the equation of centre [rad/day]
+  const double century = 36525.0;
+  const double nL = deg2rad(36000.76983) / century;
+  const double nM = deg2rad(35999.05029) / century;
+  const double c1 = deg2rad(1.914602), c2 = deg2rad(0.019993), c3 = deg2rad(0.000289);
+  double m = deg2rad(357.52911 + 35999.05029 * t);
+  double lamdaRate = nL + nM * (c1 * cos(m) + 2.0 * c2 * cos(2.0 * m) + 3.0 * c3 * cos(3.0 * m));
+  double lamdaAccel = -nM * nM * (c1 * sin(m) + 4.0 * c2 * sin(2.0 * m) + 9.0 * c3 * sin(3.0 * m));
+
+  // Equatorial rates (obliquity held constant over the servo horizon)
+  Jet lamda(lamda0, lamdaRate, lamdaAccel);
+  Jet eps(epsilon);
+  Jet alpha = Atan2(Sin(lamda) * Cos(eps), Cos(lamda));
+  Jet delta = Asin(Sin(eps) * Sin(lamda));
+
+  // Topocentric values, geocentric rates (parallax rate is negligible)
+  const double siderealRate = deg2rad(360.98564736629);
+  Jet h(hPrime, siderealRate - alpha.d, -alpha.dd);
+  Jet dec(deltaPrime, delta.d, delta.dd);
+
+  // Local Up/North/East components of the sun direction
+  Jet sinLat(k_.sinLat), cosLat(k_.cosLat);
+  Jet up = sinLat * Sin(dec) + cosLat * Cos(dec) * Cos(h);
+  Jet north = cosLat * Sin(dec) - sinLat * Cos(dec) * Cos(h);
+  Jet east = Jet(0.0) - Cos(dec) * Sin(h);
+
+  Jet azimuth = Atan2(east, north);
+  Jet e0 = Asin(up);
+  Jet e = e0;
+
+  // Refraction as in atmospheric_refraction_correction(), differentiated through e0
+  Jet e0Deg(rad2deg(e0.v), rad2deg(e0.d), rad2deg(e0.dd));
+  if (e0Deg.v >= k_.refractLimit)
+  {
+    Jet arg = e0Deg + Jet(10.3) / (e0Deg + Jet(5.11));
+    Jet argRad(deg2rad(arg.v), deg2rad(arg.d), deg2rad(arg.dd));
+    Jet delE = Jet(k_.refractScale) * Cos(argRad) / Sin(argRad);
+    e = e0 + Jet(deg2rad(delE.v), deg2rad(delE.d), deg2rad(delE.dd));
+  }
+
+  // rad/day -> degrees/s
+  const double day = 86400.0;
+  rates.azimuthRate = rad2deg(azimuth.d) / day;
+  rates.azimuthAccel = rad2deg(azimuth.dd) / (day * day);
+  rates.elevationRate = rad2deg(e.d) / day;
+  rates.elevationAccel = rad2deg(e.dd) / (day * day);
+  return rates;
+}
@@ -1,5 +1,231 @@
 #pragma once
+#include <cstddef>
+#include "IDateTime.h"
+#include "IGPSSensor.h"
+#include "IWeather.h"
+#include "SPATimeScale.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#include "spa.h"
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/*************************** USER INPUT DATA ***************************************/
+struct SiteData
+{
+  struct Position pos;  // Altitude in km, as reported by IGPSSensor
+  struct WeatherData weather;
+  double slope;         // Dish slope from the horizontal plane [degrees]
+  double azmRotation;   // Dish azimuth rotation from south, negative east [degrees]
+  double atmosRefract;  // Atmospheric refraction at sunrise/sunset [degrees]
+  SiteData(const Position &p, const WeatherData &w, const double &s = 0.0,
+           const double &a = 0.0, const double &r = 0.5667)
+      : pos(p), weather(w), slope(s), azmRotation(a), atmosRefract(r) {}
+};
+
+/* Accuracy tiers for the sun position (worst case vs spa.c over 2000-2050) */
+enum SPATIER
+{
+  SPA_TIER_EXACT = 0, // Full NREL SPA, +/-0.0003 deg: the reference
+  SPA_TIER_TRUNCATED, // SPA with leading series terms only, 0.0008 deg measured
+  SPA_TIER_PSA,       // PSA algorithm (Blanco-Muriel 2001) geocentric terms, 0.0097 deg measured
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+struct SunPosition
+{
+  double zenith;    // Topocentric zenith angle [degrees]
+  double azimuth;   // Topocentric azimuth angle, eastward from north [degrees]
+  double incidence; // Dish surface incidence angle [degrees]
+  SunPosition() : zenith(0.0), azimuth(0.0), incidence(0.0) {}
+};
+
+struct SunData
+{
+  int errCode; /* spa_calculate() error code, 0 on success */
+  SunPosition pos;
+};
+
+struct SunRates
+{
+  int errCode;           /* spa_calculate() error code, 0 on success */
+  SunPosition pos;       // Position at the instant, identical to GetSunPosition()
+  double azimuthRate;    // d(azimuth)/dt [degrees/s]
+  double elevationRate;  // d(elevation)/dt, refraction included [degrees/s]
+  double azimuthAccel;   // d2(azimuth)/dt2 [degrees/s^2]
+  double elevationAccel; // d2(elevation)/dt2 [degrees/s^2]
+};
+
+struct RtsData
+{
+  int errCode;       /* spa_calculate() error code, 0 on success */
+  double jd;         // Julian day the values were evaluated at
+  double suntransit; // Local sun transit time (solar noon) [fractional hour]
+  double sunrise;    // Local sunrise time [fractional hour], -99999 during polar day/night
+  double sunset;     // Local sunset time [fractional hour], -99999 during polar day/night
+  double srha;       // Sunrise hour angle [degrees]
+  double ssha;       // Sunset hour angle [degrees]
+  double sta;        // Sun transit altitude [degrees]
+  double eot;        // Equation of time at jd [minutes]
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/* Slowly varying geocentric sun terms, sampled on a node grid by the fast evaluators */
+struct SunNode
+{
+  static constexpr double SPACING = 0.25; // Node spacing for interpolation [days]
+
+  double alpha; // Geocentric right ascension [degrees], unwrapped along a node grid
+  double delta; // Geocentric declination [degrees]
+  double xi;    // Equatorial horizontal parallax [degrees]
+  double eqeq;  // Nutation in right ascension, del_psi * cos(epsilon) [degrees]
+
+  /* Shift alpha by whole turns so it continues prev without a 360 -> 0 jump */
+  void UnwrapAlpha(const SunNode &prev);
+
+  /* Newton forward quadratic through n0, n1, n2 at t, in units of SPACING from n0 */
+  static SunNode Interpolate(const SunNode &n0, const SunNode &n1, const SunNode &n2, double t);
+};
+
+/* Topocentric-independent sun position: Earth-fixed frame, x to Greenwich on the equator,
+   y 90 degrees west of it, z to the north pole [earth radii]. Shared by every site. */
+struct SunVector
+{
+  double x, y, z;
+};
 
 class SPALib
 {
-};
\ No newline at end of file
+public:
+  explicit SPALib(const SiteData &site, int tier = SPA_TIER_EXACT)
+      : site_(site), tier_(tier), timeScale_(&SPATimeScale::GetDefault())
+  {
+    Compile();
+  }
+
+  const SiteData &GetSite() const { return site_; }
+
+  /**
+   * @brief: Read the weather source and refresh the refraction constants only if the
+   *         temperature or pressure changed. Returns true when they were refreshed.
+   *         SetWeather() does the same for a reading already at hand (see SPAWeatherFeed).
+   */
+  bool UpdateWeather(const IWeather &weather);
+  bool SetWeather(const WeatherData &weather);
+
+  /**
+   * @brief: Select the accuracy tier (SPATIER) of the geocentric stage. The topocentric
+   *         stage (parallax, refraction, incidence) is exact in every tier.
+   */
+  void SetTier(int tier) { tier_ = tier; }
+  int GetTier() const { return tier_; }
+
+  /**
+   * @brief: Source of UT1-UTC and delta T (SPATimeScale::GetDefault() unless set).
+   *         The provider must outlive the engine and every copy of it.
+   */
+  void SetTimeScale(const SPATimeScale &scale) { timeScale_ = &scale; }
+
+  /**
+   * @brief: Sun position for a single instant at the selected tier. SPA_TIER_EXACT runs
+   *         the full spa.c series; the topocentric stage uses the compiled site.
+   */
+  SunData GetSunPosition(const DateTimeData &dt) const;
+
+  /**
+   * @brief: Same at a Julian day on the UTC scale (ClockTime::jdUtc from HighResClock),
+   *         keeping its sub-second resolution. UT1-UTC comes from the time scale.
+   */
+  SunData GetSunPosition(double jdUtc) const;
+
+  /**
+   * @brief: Fill out[0..count) with the sun position at start + i * step seconds.
+   *         Slow geocentric terms (right ascension, declination, parallax and
+   *         nutation in RA) are evaluated on a coarse node grid and interpolated;
+   *         sidereal time and the topocentric stage are exact for every sample.
+   *         Returns the spa_calculate() error code for the start time, or -1 for
+   *         a non-positive step / null buffer.
+   */
+  int GetSunSeries(const DateTimeData &start, double step, std::size_t count,
+                   SunPosition *out) const;
+
+  /**
+   * @brief: Sun position plus azimuth/elevation rates and accelerations for servo
+   *         feed-forward, from a single evaluation through the engine's tier. Hour angle
+   *         and declination rates follow from the sun's apparent longitude rate (mean
+   *         motion plus the equation of centre) and are carried through the horizon and
+   *         refraction transforms analytically.
+   */
+  SunRates GetSunRates(const DateTimeData &dt) const;
+
+  /**
+   * @brief: Uncached sunrise/transit/sunset for the local date of dt and the
+   *         equation of time at dt. See SPARtsCache for the per-day cached path.
+   */
+  RtsData GetRiseTransitSet(const DateTimeData &dt) const;
+
+  /**
+   * @brief: Validate dt against the site and return its Julian day (UT) and delta_t.
+   *         Returns the spa_calculate() error code, 0 on success.
+   */
+  int GetJulianDay(const DateTimeData &dt, double *jd, double *deltaT) const;
+  int GetJulianDayUtc(double jdUtc, double *jd, double *deltaT) const;
+
+  /**
+   * @brief: Geocentric terms at jd (UT) at the selected tier.
+   */
+  void GetSunNode(double jd, double deltaT, SunNode *node) const;
+
+  /**
+   * @brief: Topocentric stage of spa_calculate() at jd, from (interpolated) geocentric
+   *         terms. Sidereal time is evaluated exactly at jd. The parallax is applied
+   *         as a vector offset and all site trig comes precomputed, see Compile().
+   */
+  void GetTopocentric(double jd, const SunNode &node, SunPosition *out) const;
+
+  /**
+   * @brief: The topocentric stage split in two: GetSunVector() holds everything that
+   *         does not depend on the site (sidereal time, hour angle at Greenwich), so one
+   *         vector per instant serves any number of sites through GetTopocentric().
+   *         GetElevationSine() is the cheap horizon test, geometric (no refraction).
+   *         GetElevation() is the reduced stage for integrators: apparent elevation
+   *         [degrees] and the cosine of the incidence angle, without the azimuth.
+   */
+  static void GetSunVector(double jd, const SunNode &node, SunVector *out);
+  void GetTopocentric(const SunVector &v, SunPosition *out) const;
+  double GetElevationSine(const SunVector &v) const;
+  double GetElevation(const SunVector &v, double *cosIncidence) const;
+
+private:
+  /* Latitude-, elevation-, weather- and dish-dependent constants of the topocentric stage */
+  struct SiteConstants
+  {
+    double sinLat;       // Geodetic latitude
+    double cosLat;
+    double sinLon;       // Longitude
+    double cosLon;
+    double obsX;         // Observer distance from the polar axis [earth radii] (x in spa.c)
+    double obsY;         // Observer distance from the equator plane [earth radii] (y in spa.c)
+    double refractScale; // Pressure/temperature factor of the refraction correction [degrees]
+    double refractLimit; // Elevation below which refraction is not applied [degrees]
+    double cosSlope;     // Dish normal, vertical part
+    double normalN;      // Dish normal, horizontal part toward north
+    double normalE;      // Dish normal, horizontal part toward east
+  };
+
+  void FillSpaInput(const DateTimeData &dt, int function, spa_data *spa) const;
+  void FillSiteInput(spa_data *spa) const;
+  void Compile();
+  void CompileWeather();
+  double Horizon(const SunVector &v, double *north, double *east, double *cosInc) const;
+
+  SiteData site_;
+  int tier_;
+  const SPATimeScale *timeScale_;
+  SiteConstants k_;
+};
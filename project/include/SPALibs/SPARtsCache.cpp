@@ -0,0 +1,186 @@
+#include "SPARtsCache.h"
+#include <tuple>
+
+bool SPARtsCache::Key::operator<(const Key &o) const
+{
+  return std::tie(latitude, longitude, atmosRefract, timezone, year, month, date) <
+         std::tie(o.latitude, o.longitude, o.atmosRefract, o.timezone, o.year, o.month, o.date);
+}
+
+SPARtsCache::~SPARtsCache()
+{
+  {
+    // Queued dates are dropped; only the one being computed is waited for
+    std::lock_guard<std::mutex> guard(lock_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  if (worker_.joinable())
+    worker_.join();
+}
+
+SPARtsCache::Key SPARtsCache::MakeKey(const SPALib &engine, const Date &day, double timezone)
+{
+  const SiteData &site = engine.GetSite();
+  Key key = {site.pos.Latitude, site.pos.Longitude, site.atmosRefract, timezone,
+             day.year, day.month, day.date};
+  return key;
+}
+
+SPARtsCache::Entry SPARtsCache::Compute(const SPALib &engine, const Date &day, double timezone)
+{
+  Entry entry;
+  entry.rts = engine.GetRiseTransitSet(DateTimeData(day, Time(0, 0, 0, timezone)));
+  entry.eotRate = 0.0;
+  entry.served = false;
+
+  if (entry.rts.errCode == 0)
+  {
+    RtsData next = engine.GetRiseTransitSet(DateTimeData(day.NextDay(), Time(0, 0, 0, timezone)));
+    if (next.errCode == 0)
+      entry.eotRate = (next.eot - entry.rts.eot) / (next.jd - entry.rts.jd);
+  }
+  return entry;
+}
+
+void SPARtsCache::Store(const Key &key, const Entry &entry, bool served)
+{
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = entries_.find(key);
+    // Never hand the rollover of a date that has been served out a second time
+    bool wasServed = (it != entries_.end() && it->second.served);
+    entries_[key] = entry;
+    entries_[key].served = served || wasServed;
+    computing_.erase(key);
+  }
+  stored_.notify_all();
+}
+
+RtsData SPARtsCache::Get(const SPALib &engine, const DateTimeData &dt)
+{
+  Key key = MakeKey(engine, dt.dt, dt.tt.timezone);
+  Entry entry;
+  bool found, rollover = false;
+
+  {
+    std::unique_lock<std::mutex> guard(lock_);
+    // A date being computed elsewhere is waited for rather than computed twice
+    stored_.wait(guard, [&]() { return computing_.count(key) == 0; });
+    auto it = entries_.find(key);
+    found = (it != entries_.end());
+    if (found)
+    {
+      rollover = !it->second.served;
+      it->second.served = true;
+      entry = it->second;
+      hits_++;
+    }
+    else
+    {
+      misses_++;
+      // Still queued for the worker: take the job over
+      if (pending_.erase(key))
+      {
+        for (auto job = queue_.begin(); job != queue_.end(); ++job)
+        {
+          if (!(job->key < key) && !(key < job->key))
+          {
+            queue_.erase(job);
+            break;
+          }
+        }
+      }
+      computing_.insert(key);
+    }
+  }
+
+  if (!found)
+  {
+    entry = Compute(engine, dt.dt, dt.tt.timezone);
+    Store(key, entry, true);
+    rollover = true;
+  }
+
+  // First use of a date: prune the previous days and line up the next one
+  if (rollover)
+    OnDayRollover(engine, key);
+
+  RtsData rts = entry.rts;
+  if (rts.errCode == 0)
+  {
+    // Minute precision is plenty for the EOT drift, so DUT1 is left out here
+    rts.jd = julian_day(dt.dt.year, dt.dt.month, dt.dt.date, dt.tt.hour, dt.tt.minute,
+                        dt.tt.second, 0.0, dt.tt.timezone);
+    rts.eot = entry.rts.eot + entry.eotRate * (rts.jd - entry.rts.jd);
+  }
+  return rts;
+}
+
+void SPARtsCache::OnDayRollover(const SPALib &engine, const Key &today)
+{
+  {
+    // Drop the days this site has left behind
+    std::lock_guard<std::mutex> guard(lock_);
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+      const Key &k = it->first;
+      bool sameSite = k.latitude == today.latitude && k.longitude == today.longitude &&
+                      k.atmosRefract == today.atmosRefract && k.timezone == today.timezone;
+      if (sameSite && k < today)
+        it = entries_.erase(it);
+      else
+        ++it;
+    }
+  }
+  Prefetch(engine, Date(today.year, today.month, today.date).NextDay(), today.timezone);
+}
+
+void SPARtsCache::Prefetch(const SPALib &engine, const Date &day, double timezone)
+{
+  Key key = MakeKey(engine, day, timezone);
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (stopping_ || entries_.count(key) || pending_.count(key) || computing_.count(key))
+      return;
+    pending_.insert(key);
+    queue_.push_back(Job{key, engine, day, timezone});
+    // One worker for the life of the cache, started by the first prefetch
+    if (!worker_.joinable())
+      worker_ = std::thread(&SPARtsCache::WorkerMain, this);
+  }
+  wake_.notify_one();
+}
+
+void SPARtsCache::WorkerMain()
+{
+  std::unique_lock<std::mutex> guard(lock_);
+  for (;;)
+  {
+    wake_.wait(guard, [this]() { return stopping_ || !queue_.empty(); });
+    if (stopping_)
+      return;
+    Job job = queue_.front();
+    queue_.pop_front();
+    pending_.erase(job.key);
+    computing_.insert(job.key);
+
+    guard.unlock();
+    Entry entry = Compute(job.site, job.day, job.timezone);
+    Store(job.key, entry, false);
+    guard.lock();
+  }
+}
+
+std::size_t SPARtsCache::GetHits() const
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  return hits_;
+}
+
+std::size_t SPARtsCache::GetMisses() const
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  return misses_;
+}
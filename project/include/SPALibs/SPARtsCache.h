@@ -0,0 +1,90 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "SPALib.h"
+
+/**
+ * @brief: Per-site, per-date cache of sunrise/transit/sunset and equation of time.
+ *         spa_calculate() with SPA_ZA_RTS runs the geocentric series four extra times
+ *         on every call although the results only change once per day; here only the
+ *         first call of a day for a site pays for it. The first access to a date also
+ *         queues the next date for the cache's one worker thread, so the midnight
+ *         rollover of a tracking loop finds its entry already computed. A Get() for a
+ *         date still in the queue computes it itself; one for a date being computed
+ *         waits for that result.
+ */
+class SPARtsCache
+{
+public:
+  SPARtsCache() : stopping_(false), hits_(0), misses_(0) {}
+  ~SPARtsCache();
+
+  SPARtsCache(const SPARtsCache &) = delete;
+  SPARtsCache &operator=(const SPARtsCache &) = delete;
+
+  /**
+   * @brief: RTS values for the local date of dt at the engine's site. The equation
+   *         of time is interpolated to the instant in dt (error well below a second).
+   */
+  RtsData Get(const SPALib &engine, const DateTimeData &dt);
+
+  /**
+   * @brief: Queue the entry for (site, day) for the worker thread unless it is
+   *         already cached, queued or being computed.
+   */
+  void Prefetch(const SPALib &engine, const Date &day, double timezone);
+
+  std::size_t GetHits() const;
+  std::size_t GetMisses() const;
+
+private:
+  struct Key
+  {
+    double latitude;
+    double longitude;
+    double atmosRefract;
+    double timezone;
+    int year;
+    int month;
+    int date;
+    bool operator<(const Key &o) const;
+  };
+
+  struct Entry
+  {
+    RtsData rts;    // Values at local midnight of the date
+    double eotRate; // Equation of time drift [minutes/day]
+    bool served;    // Set once Get() has handed the entry out (rollover bookkeeping done)
+  };
+
+  struct Job
+  {
+    Key key;
+    SPALib site;
+    Date day;
+    double timezone;
+  };
+
+  static Key MakeKey(const SPALib &engine, const Date &day, double timezone);
+  static Entry Compute(const SPALib &engine, const Date &day, double timezone);
+  void Store(const Key &key, const Entry &entry, bool served);
+  void OnDayRollover(const SPALib &engine, const Key &today);
+  void WorkerMain();
+
+  mutable std::mutex lock_;
+  std::map<Key, Entry> entries_;
+  std::deque<Job> queue_;     // Prefetches not yet started
+  std::set<Key> pending_;     // Keys of queue_
+  std::set<Key> computing_;   // Keys being computed, by the worker or by Get()
+  std::condition_variable wake_;   // Worker: queue_ grew or stopping_
+  std::condition_variable stored_; // Get(): a key left computing_
+  bool stopping_;
+  std::thread worker_;
+  std::size_t hits_;
+  std::size_t misses_;
+};
@@ -0,0 +1,208 @@
+#include "SPASunSolver.h"
+#include <math.h>
+
+namespace
+{
+  /* Root tolerance, ~4 ms */
+  const double SOLVER_TOLERANCE_HOURS = 1.0e-6;
+  const int SOLVER_MAX_ITERATIONS = 60;
+
+  /* Step of the azimuth bracketing scan [hours] */
+  const double AZIMUTH_SCAN_HOURS = 1.0;
+
+  /* Scan intervals whose azimuth moved between these two many degrees either way are
+     ambiguous (a crossing or the wrap) and get halved, at most this many times */
+  const double AZIMUTH_AMBIGUOUS_MIN = 90.0;
+  const double AZIMUTH_AMBIGUOUS_MAX = 270.0;
+  const int AZIMUTH_MAX_SPLITS = 12;
+
+  /* Brent's method on [a, b] with f(a), f(b) of opposite sign */
+  template <typename F>
+  double Brent(F f, double a, double b, double fa, double fb)
+  {
+    double c = b, fc = fb, d = b - a, e = d;
+
+    for (int i = 0; i < SOLVER_MAX_ITERATIONS; i++)
+    {
+      if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0))
+      {
+        c = a;
+        fc = fa;
+        e = d = b - a;
+      }
+      if (fabs(fc) < fabs(fb))
+      {
+        a = b;
+        b = c;
+        c = a;
+        fa = fb;
+        fb = fc;
+        fc = fa;
+      }
+
+      double tol = 2.0 * 1.0e-15 * fabs(b) + 0.5 * SOLVER_TOLERANCE_HOURS;
+      double m = 0.5 * (c - b);
+      if (fabs(m) <= tol || fb == 0.0)
+        return b;
+
+      if (fabs(e) >= tol && fabs(fa) > fabs(fb))
+      {
+        // Inverse quadratic interpolation, or secant when only two points differ
+        double p, q, r, s = fb / fa;
+        if (a == c)
+        {
+          p = 2.0 * m * s;
+          q = 1.0 - s;
+        }
+        else
+        {
+          q = fa / fc;
+          r = fb / fc;
+          p = s * (2.0 * m * q * (q - r) - (b - a) * (r - 1.0));
+          q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+        }
+        if (p > 0)
+          q = -q;
+        else
+          p = -p;
+
+        if (2.0 * p < fmin(3.0 * m * q - fabs(tol * q), fabs(e * q)))
+        {
+          e = d;
+          d = p / q;
+        }
+        else
+        {
+          d = m;
+          e = d;
+        }
+      }
+      else
+      {
+        d = m;
+        e = d;
+      }
+
+      a = b;
+      fa = fb;
+      b += (fabs(d) > tol) ? d : (m > 0 ? tol : -tol);
+      fb = f(b);
+    }
+    return b;
+  }
+
+  /* Crossings of the wrapped azimuth difference g in [a, b]. A sign change is a crossing
+     when g moved the short way round and the wrap through +/-180 when it jumped half a
+     turn or more; near the zenith the sweep is fast enough to be ambiguous at the scan
+     step, so such intervals are split until the move is small. */
+  template <typename G>
+  void AzimuthCrossings(G g, double a, double b, double ga, double gb, int depth, SunEvent *ev)
+  {
+    if (ev->count >= 2)
+      return;
+    double jump = fabs(gb - ga);
+    if (jump > AZIMUTH_AMBIGUOUS_MIN && jump < AZIMUTH_AMBIGUOUS_MAX && depth < AZIMUTH_MAX_SPLITS)
+    {
+      double m = 0.5 * (a + b), gm = g(m);
+      AzimuthCrossings(g, a, m, ga, gm, depth + 1, ev);
+      AzimuthCrossings(g, m, b, gm, gb, depth + 1, ev);
+      return;
+    }
+    if (((ga < 0 && gb >= 0) || (ga >= 0 && gb < 0)) && jump < 180.0)
+      ev->hour[ev->count++] = Brent(g, a, b, ga, gb);
+  }
+}
+
+int SPASunSolver::Prepare(const Date &day, double timezone)
+{
+  if (!ephemeris_.IsEmpty() && day_ == day && timezone_ == timezone)
+    return 0;
+
+  DateTimeData midnight(day, Time(0, 0, 0, timezone));
+  double deltaT;
+  int result = engine_.GetJulianDay(midnight, &jdMidnight_, &deltaT);
+  if (result != 0)
+    return result;
+
+  RtsData rts = cache_.Get(engine_, DateTimeData(day, Time(12, 0, 0, timezone)));
+  if (rts.errCode == 0 && rts.suntransit >= 0)
+    transit_ = rts.suntransit;
+  else
+  {
+    // Polar day or night: approximate solar noon is close enough to bracket around
+    transit_ = 12.0 - engine_.GetSite().pos.Longitude / 15.0 + timezone;
+    transit_ -= 24.0 * floor(transit_ / 24.0);
+  }
+
+  // Brackets reach 12 h either side of a transit that lies within the date
+  result = ephemeris_.Build(midnight, 1.5, 0.5);
+  if (result != 0)
+    return result;
+
+  day_ = day;
+  timezone_ = timezone;
+  return 0;
+}
+
+SunPosition SPASunSolver::Evaluate(double hour) const
+{
+  SunPosition pos;
+  ephemeris_.GetSunPosition(jdMidnight_ + hour / 24.0, &pos);
+  return pos;
+}
+
+int SPASunSolver::GetSunPosition(const Date &day, double timezone, double hour, SunPosition *out)
+{
+  int result = Prepare(day, timezone);
+  if (result == 0)
+    *out = Evaluate(hour);
+  return result;
+}
+
+SunEvent SPASunSolver::TimeAtElevation(const Date &day, double timezone, double elevation)
+{
+  SunEvent ev;
+  ev.errCode = Prepare(day, timezone);
+  if (ev.errCode != 0)
+    return ev;
+
+  auto f = [this, elevation](double hour) -> double
+  {
+    return (90.0 - Evaluate(hour).zenith) - elevation;
+  };
+
+  // Elevation climbs from the anti-transit minimum to the transit maximum and back
+  double t0 = transit_ - 12.0, t1 = transit_, t2 = transit_ + 12.0;
+  double f0 = f(t0), f1 = f(t1), f2 = f(t2);
+
+  if (f0 < 0 && f1 >= 0)
+    ev.hour[ev.count++] = Brent(f, t0, t1, f0, f1);
+  if (f1 >= 0 && f2 < 0)
+    ev.hour[ev.count++] = Brent(f, t1, t2, f1, f2);
+  return ev;
+}
+
+SunEvent SPASunSolver::TimeAtAzimuth(const Date &day, double timezone, double azimuth)
+{
+  SunEvent ev;
+  ev.errCode = Prepare(day, timezone);
+  if (ev.errCode != 0)
+    return ev;
+
+  auto g = [this, azimuth](double hour) -> double
+  {
+    return remainder(Evaluate(hour).azimuth - azimuth, 360.0);
+  };
+
+  // Azimuth is not monotonic everywhere (tropics), so bracket with a coarse scan
+  double a = transit_ - 12.0, ga = g(a);
+  for (double b = a + AZIMUTH_SCAN_HOURS; b <= transit_ + 12.0 && ev.count < 2;
+       b += AZIMUTH_SCAN_HOURS)
+  {
+    double gb = g(b);
+    AzimuthCrossings(g, a, b, ga, gb, 0, &ev);
+    a = b;
+    ga = gb;
+  }
+  return ev;
+}
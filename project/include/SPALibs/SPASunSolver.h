@@ -0,0 +1,54 @@
+#pragma once
+#include "SPALib.h"
+#include "SPAEphemeris.h"
+#include "SPARtsCache.h"
+
+/*************************** USER OUTPUT DATA **************************************/
+struct SunEvent
+{
+  int errCode;    /* spa_calculate() error code, 0 on success */
+  int count;      // Crossings found in the 24 h centred on the day's transit (0 to 2)
+  double hour[2]; // Local times of the crossings [fractional hour from the date's midnight]
+  SunEvent() : errCode(0), count(0) { hour[0] = hour[1] = -99999; }
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/**
+ * @brief: Reverse sun-position queries for a site: when does the sun reach a given
+ *         elevation or cross a given azimuth on a date. Crossings are bracketed around
+ *         the cached solar transit (SPARtsCache) and refined with Brent's method on a
+ *         per-day SPAEphemeris, so a query after the first of the day costs a few
+ *         dozen fast evaluations. Crossing hours can fall slightly outside 0..24 when
+ *         they belong to the neighbouring day.
+ */
+class SPASunSolver
+{
+public:
+  SPASunSolver(const SPALib &engine, SPARtsCache &cache)
+      : engine_(engine), cache_(cache), ephemeris_(engine), day_(0, 0, 0), timezone_(0.0),
+        jdMidnight_(0.0), transit_(0.0) {}
+
+  /* Sunrise-side crossing first; elevation includes refraction like spa_calculate() */
+  SunEvent TimeAtElevation(const Date &day, double timezone, double elevation);
+
+  /* Azimuth eastward from north [degrees] */
+  SunEvent TimeAtAzimuth(const Date &day, double timezone, double azimuth);
+
+  /* Fast-path sun position at a local hour of the date; returns the error code */
+  int GetSunPosition(const Date &day, double timezone, double hour, SunPosition *out);
+
+  /* The engine's site changed: rebuild the day's ephemeris on the next query */
+  void Reset() { day_ = Date(0, 0, 0); }
+
+private:
+  int Prepare(const Date &day, double timezone);
+  SunPosition Evaluate(double hour) const;
+
+  const SPALib &engine_;
+  SPARtsCache &cache_;
+  SPAEphemeris ephemeris_;
+  Date day_;
+  double timezone_;
+  double jdMidnight_; // Julian day of the date's local midnight
+  double transit_;    // Local solar transit [fractional hour]
+};
@@ -0,0 +1,157 @@
+#include "SPATimeScale.h"
+#include <fstream>
+#include <math.h>
+#include <sstream>
+#include <string>
+
+namespace
+{
+  /* TT - TAI [s] */
+  const double TT_TAI = 32.184;
+}
+
+int SPATimeScale::Load(const char *path)
+{
+  std::ifstream in(path);
+  if (!in)
+    return LOAD_NO_FILE;
+
+  std::vector<TimeScaleRow> rows;
+  std::string line;
+  double taiUtc = 37.0;
+  while (std::getline(in, line))
+  {
+    std::size_t hash = line.find('#');
+    if (hash != std::string::npos)
+      line.erase(hash);
+
+    std::istringstream fields(line);
+    double mjd, dut1;
+    if (!(fields >> mjd))
+      continue; // Blank or comment-only line
+    if (!(fields >> dut1))
+      return LOAD_BAD_ROW;
+    double t;
+    if (fields >> t)
+      taiUtc = t;
+    rows.push_back(TimeScaleRow(mjd, dut1, taiUtc));
+  }
+  return Load(rows);
+}
+
+int SPATimeScale::Load(const std::vector<TimeScaleRow> &rows)
+{
+  if (rows.empty())
+    return LOAD_EMPTY;
+  for (std::size_t i = 1; i < rows.size(); i++)
+  {
+    if (rows[i].mjd != rows[i - 1].mjd + 1.0)
+      return LOAD_BAD_ROW;
+  }
+
+  std::lock_guard<std::mutex> guard(lock_);
+  rows_ = rows;
+  generation_++;
+  return LOAD_OK;
+}
+
+bool SPATimeScale::IsLoaded() const
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  return !rows_.empty();
+}
+
+long SPATimeScale::ToMjd(const Date &day)
+{
+  // Fliegel & Van Flandern day number, minus the MJD epoch
+  long y = day.year, m = day.month, d = day.date;
+  long a = (14 - m) / 12;
+  long yy = y + 4800 - a;
+  long mm = m + 12 * a - 3;
+  long jdn = d + (153 * mm + 2) / 5 + 365 * yy + yy / 4 - yy / 100 + yy / 400 - 32045;
+  return jdn - 2400001;
+}
+
+TimeScaleData SPATimeScale::Get(const DateTimeData &dt) const
+{
+  // The local date is a day off the UTC one for part of the day away from UTC
+  const Time &t = dt.tt;
+  double utcHour = t.hour + t.minute / 60.0 + t.second / 3600.0 - t.timezone;
+  return GetDay(ToMjd(dt.dt) + static_cast<long>(floor(utcHour / 24.0)));
+}
+
+TimeScaleData SPATimeScale::GetForJd(double jdUtc) const
+{
+  return GetDay(static_cast<long>(floor(jdUtc - 2400000.5)));
+}
+
+TimeScaleData SPATimeScale::GetDay(long mjd) const
+{
+  // One memo per thread: no lock on the per-tick path, and a worker pool never
+  // thrashes a shared entry with different days
+  struct Memo
+  {
+    const SPATimeScale *owner;
+    unsigned generation;
+    long mjd;
+    TimeScaleData value;
+  };
+  thread_local Memo memo = {nullptr, 0, 0, TimeScaleData()};
+
+  unsigned generation = generation_.load(std::memory_order_acquire);
+  if (memo.owner == this && memo.generation == generation && memo.mjd == mjd)
+    return memo.value;
+
+  memo.value = GetAt(static_cast<double>(mjd));
+  memo.owner = this;
+  memo.generation = generation;
+  memo.mjd = mjd;
+  return memo.value;
+}
+
+TimeScaleData SPATimeScale::GetAt(double mjd) const
+{
+  TimeScaleData value;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (!rows_.empty() && mjd >= rows_.front().mjd && mjd <= rows_.back().mjd)
+    {
+      // Rows are one day apart: the index is the day offset
+      std::size_t last = rows_.size() - 1;
+      std::size_t i = static_cast<std::size_t>(mjd - rows_.front().mjd);
+      const TimeScaleRow &a = rows_[i < last ? i : last];
+      const TimeScaleRow &b = rows_[i < last ? i + 1 : last];
+      double f = mjd - a.mjd;
+
+      // UT1 - TAI is continuous across a leap second, UT1 - UTC is not
+      double ut1Tai = (a.dut1 - a.taiUtc) + f * ((b.dut1 - b.taiUtc) - (a.dut1 - a.taiUtc));
+      double taiUtc = f < 1.0 ? a.taiUtc : b.taiUtc;
+      value.dut1 = ut1Tai + taiUtc;
+      value.deltaT = TT_TAI - ut1Tai;
+      value.tabulated = true;
+      return value;
+    }
+  }
+
+  // Prediction formula, evaluated for the calendar date of mjd
+  long jdn = static_cast<long>(floor(mjd)) + 2400001;
+  long a = jdn + 32044;
+  long b = (4 * a + 3) / 146097;
+  long c = a - 146097 * b / 4;
+  long d = (4 * c + 3) / 1461;
+  long e = c - 1461 * d / 4;
+  long m = (5 * e + 2) / 153;
+  DateTimeData dt(static_cast<int>(100 * b + d - 4800 + m / 10),
+                  static_cast<int>(m + 3 - 12 * (m / 10)),
+                  static_cast<int>(e - (153 * m + 2) / 5 + 1), 0, 0, 0, 0.0);
+  value.dut1 = dt.GetDelta_UT1();
+  value.deltaT = dt.GetDelta_T();
+  value.tabulated = false;
+  return value;
+}
+
+SPATimeScale &SPATimeScale::GetDefault()
+{
+  static SPATimeScale scale;
+  return scale;
+}
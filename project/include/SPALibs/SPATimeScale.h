@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "IDateTime.h"
+
+/*************************** USER INPUT DATA ***************************************/
+/* One day of an IERS-style Earth orientation table */
+struct TimeScaleRow
+{
+  double mjd;    // Modified Julian Date of 0h UTC
+  double dut1;   // UT1 - UTC [s]
+  double taiUtc; // TAI - UTC, the leap second count [s]
+  TimeScaleRow(const double &m, const double &d, const double &t = 37.0)
+      : mjd(m), dut1(d), taiUtc(t) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+struct TimeScaleData
+{
+  double dut1;   // UT1 - UTC [s], spa_data::delta_ut1
+  double deltaT; // TT - UT1 [s], spa_data::delta_t
+  bool tabulated; // False when the prediction formula answered
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/**
+ * @brief: UT1-UTC and delta T for the SPA inputs. Inside a loaded daily table the value
+ *         is an O(1) linear interpolation (done on UT1-TAI, which does not jump at leap
+ *         seconds); outside it DateTimeData's prediction formula answers. Results are
+ *         memoised per UTC day, so a tracking loop pays for one lookup a day.
+ */
+class SPATimeScale
+{
+public:
+  enum LOADERROR
+  {
+    LOAD_OK = 0,
+    LOAD_NO_FILE = -1,    // File could not be opened
+    LOAD_BAD_ROW = -2,    // Unparsable row, or MJDs not on consecutive days
+    LOAD_EMPTY = -3,      // No rows
+  };
+
+  SPATimeScale() : generation_(1) {}
+
+  SPATimeScale(const SPATimeScale &) = delete;
+  SPATimeScale &operator=(const SPATimeScale &) = delete;
+
+  /**
+   * @brief: Load "MJD UT1-UTC [TAI-UTC]" rows, one per day, '#' starts a comment.
+   *         A missing TAI-UTC repeats the previous row's (37 s for the first).
+   *         On error the current table is kept.
+   */
+  int Load(const char *path);
+  int Load(const std::vector<TimeScaleRow> &rows);
+
+  /* Values for the UTC day holding a local time / a Julian day, memoised per thread */
+  TimeScaleData Get(const DateTimeData &dt) const;
+  TimeScaleData GetForJd(double jdUtc) const;
+
+  /* Values at a fractional MJD (UTC), not memoised */
+  TimeScaleData GetAt(double mjd) const;
+
+  bool IsLoaded() const;
+
+  /* Process-wide provider used by SPALib unless told otherwise */
+  static SPATimeScale &GetDefault();
+
+private:
+  static long ToMjd(const Date &day);
+  TimeScaleData GetDay(long mjd) const;
+
+  mutable std::mutex lock_;
+  std::vector<TimeScaleRow> rows_;
+  std::atomic<unsigned> generation_; // Bumped by Load() to drop the per-thread memos
+};
@@ -0,0 +1,148 @@
+#include "SPATrackingGate.h"
+#include <math.h>
+
+namespace
+{
+  DateTimeData AtLocalHour(const Date &day, double hour, double timezone)
+  {
+    int s = static_cast<int>(floor(hour * 3600.0 + 0.5));
+    if (s < 0)
+      s = 0;
+    if (s > 86399)
+      s = 86399;
+    return DateTimeData(day, Time(s / 3600, (s / 60) % 60, s % 60, timezone));
+  }
+}
+
+SPATrackingGate::Window SPATrackingGate::ComputeWindow(const Date &day, double timezone)
+{
+  const double thr = config_.minElevation;
+  SunEvent ev = solver_.TimeAtElevation(day, timezone, thr);
+
+  // Let the tracking path surface the error instead of sleeping through it
+  if (ev.errCode != 0)
+    return Window(day, 0.0, 24.0);
+
+  if (ev.count == 2)
+    return Window(day, fmax(ev.hour[0], 0.0), fmin(ev.hour[1], 24.0));
+
+  // Polar day or night, or the single crossing at its edge
+  SunPosition pos;
+  if (ev.count == 0)
+  {
+    solver_.GetSunPosition(day, timezone, 12.0, &pos);
+    return (90.0 - pos.zenith >= thr) ? Window(day, 0.0, 24.0) : Window(day, -1.0, -1.0);
+  }
+
+  solver_.GetSunPosition(day, timezone, ev.hour[0] - 0.25, &pos);
+  if (90.0 - pos.zenith < thr)
+    return Window(day, fmax(ev.hour[0], 0.0), 24.0);
+  return Window(day, 0.0, fmin(ev.hour[0], 24.0));
+}
+
+const SPATrackingGate::Window &SPATrackingGate::GetWindow(const Date &day, double timezone)
+{
+  if (today_.day == day)
+    return today_;
+  if (tomorrow_.day == day)
+    today_ = tomorrow_;
+  else
+    today_ = ComputeWindow(day, timezone);
+  return today_;
+}
+
+double SPATrackingGate::NextWake(const DateTimeData &now, double hour, DateTimeData *wakeAt)
+{
+  const Window &w = GetWindow(now.dt, now.tt.timezone);
+  if (w.wake >= 0 && hour < w.wake)
+  {
+    *wakeAt = AtLocalHour(now.dt, w.wake, now.tt.timezone);
+    return (w.wake - hour) * 3600.0;
+  }
+
+  Date next = now.dt.NextDay();
+  if (!(tomorrow_.day == next))
+    tomorrow_ = ComputeWindow(next, now.tt.timezone);
+
+  // No window tomorrow either (polar night): check back at the next midnight
+  double wake = (tomorrow_.wake >= 0) ? tomorrow_.wake : 0.0;
+  *wakeAt = AtLocalHour(next, wake, now.tt.timezone);
+  return (24.0 - hour + wake) * 3600.0;
+}
+
+void SPATrackingGate::Relocate()
+{
+  solver_.Reset();
+  today_ = tomorrow_ = Window(Date(0, 0, 0), -1.0, -1.0);
+}
+
+void SPATrackingGate::Rollover(const Date &day)
+{
+  if (stats_.ticks > 0)
+    lastDay_ = stats_;
+  stats_ = GateStats();
+  stats_.day = day;
+}
+
+GateDecision SPATrackingGate::Update(const DateTimeData &now)
+{
+  GateDecision d = Check(now);
+  if (d.state != GATE_TRACKING)
+    return d;
+
+  SunData sun = engine_.GetSunPosition(now);
+  d.errCode = sun.errCode;
+  d.target = sun.pos;
+  d.sendCommand = (sun.errCode == 0);
+  if (d.sendCommand)
+    stats_.commands++;
+  return d;
+}
+
+GateDecision SPATrackingGate::Check(const DateTimeData &now)
+{
+  GateDecision d;
+  d.errCode = 0;
+  d.sendCommand = false;
+  d.wakeIn = 0.0;
+
+  if (!(stats_.day == now.dt))
+    Rollover(now.dt);
+  stats_.ticks++;
+
+  double hour = now.tt.hour + now.tt.minute / 60.0 + now.tt.second / 3600.0;
+  const Window &w = GetWindow(now.dt, now.tt.timezone);
+
+  if (w.wake >= 0 && hour >= w.wake && hour <= w.sleep)
+  {
+    stats_.spaEvaluations++;
+    d.state = state_ = GATE_TRACKING;
+    return d;
+  }
+
+  DateTimeData wakeAt = now;
+  d.wakeIn = NextWake(now, hour, &wakeAt);
+
+  if (state_ == GATE_TRACKING)
+  {
+    // One stow move: park facing where the sun will be when tracking resumes
+    SunData sun = engine_.GetSunPosition(wakeAt);
+    stats_.spaEvaluations++;
+    d.errCode = sun.errCode;
+    d.target = sun.pos;
+    d.target.zenith = config_.stowZenith;
+    d.state = GATE_STOWING;
+    d.sendCommand = (sun.errCode == 0);
+    if (d.sendCommand)
+    {
+      state_ = GATE_STOWING; // A failed stow is retried on the next call
+      stats_.commands++;
+    }
+    return d;
+  }
+
+  d.state = state_ = GATE_SLEEPING;
+  stats_.spaSaved++;
+  stats_.commandsSaved++;
+  return d;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include "SPALib.h"
+#include "SPARtsCache.h"
+#include "SPASunSolver.h"
+
+/*************************** USER INPUT DATA ***************************************/
+struct GateConfig
+{
+  double minElevation; // Lowest sun elevation worth tracking for this dish [degrees]
+  double stowZenith;   // Zenith angle the dish parks at while asleep [degrees]
+  GateConfig(const double &e = 0.0, const double &z = 90.0)
+      : minElevation(e), stowZenith(z) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+enum GATESTATE
+{
+  GATE_TRACKING = 0, // Sun above the threshold: evaluate SPA and command the dish
+  GATE_STOWING,      // Just went to sleep: one stow command toward the next wake azimuth
+  GATE_SLEEPING,     // Nothing to do until wakeIn has elapsed
+};
+
+struct GateDecision
+{
+  int errCode;        /* spa_calculate() error code, 0 on success */
+  int state;          // GATESTATE
+  bool sendCommand;   // True when target should be sent to the actuators
+  SunPosition target; // Sun position (tracking) or stow position (stowing)
+  double wakeIn;      // Seconds until the next useful event (0 while tracking)
+};
+
+struct GateStats
+{
+  Date day;                     // Local date the counters belong to
+  std::size_t ticks;            // Update() calls
+  std::size_t spaEvaluations;   // SPA evaluations actually run by the loop
+  std::size_t spaSaved;         // Evaluations an ungated loop would have run on top
+  std::size_t commands;         // Actuator commands issued
+  std::size_t commandsSaved;    // Commands an ungated loop would have issued on top
+  GateStats() : day(0, 0, 0), ticks(0), spaEvaluations(0), spaSaved(0), commands(0),
+                commandsSaved(0) {}
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/**
+ * @brief: Night / low-sun gate for the tracking loop. The useful window of each day
+ *         (sun above GateConfig::minElevation) is solved once with SPASunSolver
+ *         around the cached solar transit; outside of it the gate issues a single stow command
+ *         and then reports how long the loop may sleep, skipping SPA and actuator work.
+ *         TrackingCore runs one through Check() in front of its sun and command stages,
+ *         so the counters are what the daemon and the fleet actually skipped.
+ */
+class SPATrackingGate
+{
+public:
+  SPATrackingGate(const SPALib &engine, SPARtsCache &cache, const GateConfig &config)
+      : engine_(engine), solver_(engine, cache), config_(config), state_(GATE_TRACKING),
+        today_(Date(0, 0, 0), -1.0, -1.0), tomorrow_(Date(0, 0, 0), -1.0, -1.0) {}
+
+  GateDecision Update(const DateTimeData &now);
+
+  /**
+   * @brief: The same decision for a loop that runs its own sun pipeline: GATE_TRACKING
+   *         only clears it to evaluate and command (counted as one SPA evaluation), the
+   *         gate itself runs SPA just for the stow target. Commands the loop sends while
+   *         tracking are reported back with CountCommand().
+   */
+  GateDecision Check(const DateTimeData &now);
+  void CountCommand() { stats_.commands++; }
+
+  /* The engine's site moved: re-solve the windows, keep the state and the counters */
+  void Relocate();
+
+  const GateStats &GetStats() const { return stats_; }         // Current day so far
+  const GateStats &GetLastDayStats() const { return lastDay_; } // Last completed day
+
+private:
+  struct Window
+  {
+    Date day;
+    double wake;  // Local hour the sun climbs above the threshold, -1 if it never does
+    double sleep; // Local hour the sun drops below it, -1 if it never rises
+    Window(const Date &d, double w, double s) : day(d), wake(w), sleep(s) {}
+  };
+
+  Window ComputeWindow(const Date &day, double timezone);
+  const Window &GetWindow(const Date &day, double timezone);
+  double NextWake(const DateTimeData &now, double hour, DateTimeData *wakeAt);
+  void Rollover(const Date &day);
+
+  const SPALib &engine_;
+  SPASunSolver solver_;
+  GateConfig config_;
+  int state_;
+  Window today_;
+  Window tomorrow_;
+  GateStats stats_;
+  GateStats lastDay_;
+};
@@ -0,0 +1,54 @@
+#include "SPAWeatherFeed.h"
+#include <math.h>
+
+bool SPAWeatherFeed::IsValid(const WeatherData &w)
+{
+  // Same limits as validate_inputs() in spa.c; the negated form also rejects NaN
+  return (w.presure >= 0.0 && w.presure <= 5000.0) &&
+         (w.temp > -273.0 && w.temp <= 6000.0);
+}
+
+bool SPAWeatherFeed::Update(double now)
+{
+  if (source_ == nullptr || (primed_ && now - lastSample_ < config_.sampleInterval))
+    return false;
+  return Add(source_->GetWeatherData(), now);
+}
+
+bool SPAWeatherFeed::Add(const WeatherData &w, double now)
+{
+  if (!IsValid(w))
+  {
+    stats_.rejected++;
+    return false;
+  }
+  stats_.samples++;
+
+  if (!primed_)
+  {
+    // First reading replaces the configured site weather outright
+    primed_ = true;
+    lastSample_ = now;
+    filtered_ = w;
+  }
+  else
+  {
+    // Exponential smoothing with the gain of an RC filter over the actual gap
+    double gain = 1.0 - exp(-(now - lastSample_) / config_.timeConstant);
+    lastSample_ = now;
+    filtered_.temp += gain * (w.temp - filtered_.temp);
+    filtered_.presure += gain * (w.presure - filtered_.presure);
+    filtered_.humidity += gain * (w.humidity - filtered_.humidity);
+  }
+
+  if (engine_ == nullptr)
+    return false;
+  const WeatherData &applied = engine_->GetSite().weather;
+  if (fabs(filtered_.temp - applied.temp) < config_.tempThreshold &&
+      fabs(filtered_.presure - applied.presure) < config_.presureThreshold)
+    return false;
+
+  engine_->SetWeather(filtered_);
+  stats_.refreshes++;
+  return true;
+}
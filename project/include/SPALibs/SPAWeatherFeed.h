@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include "SPALib.h"
+
+/*************************** USER INPUT DATA ***************************************/
+struct WeatherFeedConfig
+{
+  double sampleInterval;    // Minimum time between IWeather reads [s]
+  double timeConstant;      // Low-pass filter time constant [s]
+  double tempThreshold;     // Filtered temperature change that refreshes refraction [C]
+  double presureThreshold;  // Filtered pressure change that refreshes refraction [mbar]
+  WeatherFeedConfig(const double &i = 60.0, const double &t = 600.0,
+                    const double &dt = 0.5, const double &dp = 1.0)
+      : sampleInterval(i), timeConstant(t), tempThreshold(dt), presureThreshold(dp) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+struct WeatherFeedStats
+{
+  std::size_t samples;   // IWeather reads accepted into the filter
+  std::size_t rejected;  // Reads outside the range spa_calculate() accepts
+  std::size_t refreshes; // Refraction refreshes pushed to the engine
+  WeatherFeedStats() : samples(0), rejected(0), refreshes(0) {}
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/**
+ * @brief: Feeds live IWeather readings into the SPALib refraction correction. The
+ *         source is sampled at most once per sampleInterval and smoothed with a first
+ *         order low-pass filter; the engine is only updated when the filtered value
+ *         has moved past a threshold from what it last received. Sensor noise near
+ *         the horizon then no longer shifts the target every tick and makes the dish hunt.
+ */
+class SPAWeatherFeed
+{
+public:
+  SPAWeatherFeed(SPALib &engine, const IWeather &source,
+                 const WeatherFeedConfig &config = WeatherFeedConfig())
+      : engine_(&engine), source_(&source), config_(config), primed_(false), lastSample_(0.0),
+        filtered_(engine.GetSite().weather) {}
+
+  /* Fed with Add() instead of polling a source; bind the engine with SetEngine(). Until
+     a valid reading arrives GetFiltered() is the standard atmosphere, not 0 C / 0 mbar
+     (which would switch refraction off). */
+  explicit SPAWeatherFeed(const WeatherFeedConfig &config = WeatherFeedConfig())
+      : engine_(nullptr), source_(nullptr), config_(config), primed_(false), lastSample_(0.0),
+        filtered_(StandardAtmosphere()) {}
+
+  /**
+   * @brief: Call from the tracking loop with a monotonic time in seconds. Returns true
+   *         when the engine's refraction constants were refreshed by this call.
+   */
+  bool Update(double now);
+
+  /**
+   * @brief: Filter a reading taken at a monotonic time [s], for callers that already
+   *         hold timestamped samples; no sampleInterval throttling. Returns true when
+   *         the engine's refraction constants were refreshed by this call.
+   */
+  bool Add(const WeatherData &w, double now);
+
+  /* Engine the filtered value is pushed to, nullptr to only filter (e.g. while rebuilding
+     it: construct the new one from GetFiltered()) */
+  void SetEngine(SPALib *engine) { engine_ = engine; }
+
+  bool IsPrimed() const { return primed_; }
+  const WeatherData &GetFiltered() const { return filtered_; }
+  const WeatherFeedStats &GetStats() const { return stats_; }
+
+  /* ISO 2533 sea level: 15 C, 1013.25 mbar, dry */
+  static WeatherData StandardAtmosphere() { return WeatherData(15.0, 1013.25, 0.0); }
+
+private:
+  static bool IsValid(const WeatherData &w);
+
+  SPALib *engine_;
+  const IWeather *source_;
+  WeatherFeedConfig config_;
+  bool primed_;
+  double lastSample_;
+  WeatherData filtered_;
+  WeatherFeedStats stats_;
+};
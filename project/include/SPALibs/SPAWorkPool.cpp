@@ -0,0 +1,121 @@
+#include "SPAWorkPool.h"
+
+SPAWorkPool::SPAWorkPool(unsigned threads)
+    : task_(nullptr), generation_(0), busy_(0), quit_(false), steals_(0)
+{
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency();
+  if (threads == 0)
+    threads = 1;
+
+  for (unsigned i = 0; i < threads; i++)
+    queues_.emplace_back(new Queue());
+  for (unsigned i = 1; i < threads; i++)
+    threads_.emplace_back(&SPAWorkPool::WorkerMain, this, i);
+}
+
+SPAWorkPool::~SPAWorkPool()
+{
+  {
+    std::lock_guard<std::mutex> guard(jobLock_);
+    quit_ = true;
+  }
+  jobStart_.notify_all();
+  for (auto &t : threads_)
+    t.join();
+}
+
+void SPAWorkPool::ParallelFor(std::size_t count, std::size_t grain, const Task &task)
+{
+  if (count == 0)
+    return;
+  if (grain == 0)
+    grain = 1;
+
+  // Deal contiguous blocks of chunks, one block per worker
+  const std::size_t workers = queues_.size();
+  const std::size_t chunks = (count + grain - 1) / grain;
+  for (std::size_t w = 0; w < workers; w++)
+  {
+    std::size_t first = chunks * w / workers;
+    std::size_t last = chunks * (w + 1) / workers;
+    std::lock_guard<std::mutex> guard(queues_[w]->lock);
+    for (std::size_t c = first; c < last; c++)
+    {
+      Range r = {c * grain, (c + 1) * grain < count ? (c + 1) * grain : count};
+      queues_[w]->ranges.push_back(r);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(jobLock_);
+    task_ = &task;
+    busy_ = static_cast<unsigned>(workers);
+    generation_++;
+  }
+  jobStart_.notify_all();
+
+  Drain(0);
+
+  std::unique_lock<std::mutex> guard(jobLock_);
+  busy_--;
+  jobDone_.wait(guard, [this] { return busy_ == 0; });
+  task_ = nullptr;
+}
+
+void SPAWorkPool::WorkerMain(unsigned worker)
+{
+  std::size_t seen = 0;
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> guard(jobLock_);
+      jobStart_.wait(guard, [&] { return quit_ || generation_ != seen; });
+      if (quit_)
+        return;
+      seen = generation_;
+    }
+
+    Drain(worker);
+
+    std::lock_guard<std::mutex> guard(jobLock_);
+    if (--busy_ == 0)
+      jobDone_.notify_all();
+  }
+}
+
+void SPAWorkPool::Drain(unsigned worker)
+{
+  // No chunks are added while a job runs, so empty queues everywhere means done
+  Range r;
+  while (PopOwn(worker, &r) || Steal(worker, &r))
+    (*task_)(r.begin, r.end, worker);
+}
+
+bool SPAWorkPool::PopOwn(unsigned worker, Range *range)
+{
+  Queue &q = *queues_[worker];
+  std::lock_guard<std::mutex> guard(q.lock);
+  if (q.ranges.empty())
+    return false;
+  *range = q.ranges.front();
+  q.ranges.pop_front();
+  return true;
+}
+
+bool SPAWorkPool::Steal(unsigned worker, Range *range)
+{
+  const std::size_t workers = queues_.size();
+  for (std::size_t i = 1; i < workers; i++)
+  {
+    Queue &q = *queues_[(worker + i) % workers];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.ranges.empty())
+      continue;
+    *range = q.ranges.back();
+    q.ranges.pop_back();
+    steals_++;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief: Fixed set of worker threads running parallel-for jobs with work stealing.
+ *         The index range is cut into chunks of `grain` and dealt out in contiguous
+ *         blocks, one block per worker, so neighbouring indices (consecutive days of
+ *         one site) stay on one core. A worker that runs dry takes chunks from the far
+ *         end of another worker's queue, which evens out uneven task costs (polar
+ *         nights, short winter days) without a central queue.
+ */
+class SPAWorkPool
+{
+public:
+  /* Range task: process indices [begin, end) on worker `worker` (0..GetThreadCount()-1) */
+  typedef std::function<void(std::size_t begin, std::size_t end, unsigned worker)> Task;
+
+  /* threads = 0 uses every hardware thread. The calling thread counts as one worker. */
+  explicit SPAWorkPool(unsigned threads = 0);
+  ~SPAWorkPool();
+
+  SPAWorkPool(const SPAWorkPool &) = delete;
+  SPAWorkPool &operator=(const SPAWorkPool &) = delete;
+
+  /**
+   * @brief: Run task over [0, count) in chunks of grain and return when all are done.
+   *         Not reentrant: one job at a time per pool.
+   */
+  void ParallelFor(std::size_t count, std::size_t grain, const Task &task);
+
+  unsigned GetThreadCount() const { return static_cast<unsigned>(queues_.size()); }
+  std::size_t GetSteals() const { return steals_; } // Chunks run by a worker other than their owner
+
+private:
+  struct Range
+  {
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  struct Queue
+  {
+    std::mutex lock;
+    std::deque<Range> ranges;
+  };
+
+  void WorkerMain(unsigned worker);
+  void Drain(unsigned worker);
+  bool PopOwn(unsigned worker, Range *range);
+  bool Steal(unsigned worker, Range *range);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+
+  std::mutex jobLock_;
+  std::condition_variable jobStart_;
+  std::condition_variable jobDone_;
+  const Task *task_;
+  std::size_t generation_;
+  unsigned busy_;
+  bool quit_;
+  std::atomic<std::size_t> steals_;
+};
@@ -0,0 +1,193 @@
+#include "SPAYieldSim.h"
+#include <atomic>
+#include <math.h>
+#include "SPAEphemeris.h"
+
+namespace
+{
+  /* Total solar irradiance at 1 AU [W/m^2] (Kopp & Lean 2011) */
+  const double SOLAR_CONSTANT = 1361.0;
+
+  /* Geometric elevation below which refraction cannot lift the sun over the horizon */
+  const double HORIZON_SINE = -0.0349; // sin(-2 deg)
+
+  /* (site, day) tasks per work-stealing chunk */
+  const std::size_t GRAIN = 8;
+
+  /* Relative optical air mass (Kasten & Young 1989), zenith in degrees */
+  double AirMass(double zenith)
+  {
+    return 1.0 / (cos(deg2rad(zenith)) + 0.50572 * pow(96.07995 - zenith, -1.6364));
+  }
+
+  /* Meinel sea-level beam transmittance 0.7^(AM^0.678), tabulated over apparent
+     elevation so the per-step cost is a lookup instead of three pow() calls */
+  class Transmittance
+  {
+  public:
+    static const int STEPS_PER_DEGREE = 100;
+
+    Transmittance() : table_(90 * STEPS_PER_DEGREE + 2)
+    {
+      for (std::size_t i = 0; i < table_.size(); i++)
+      {
+        double e = fmin(static_cast<double>(i) / STEPS_PER_DEGREE, 90.0);
+        table_[i] = pow(0.7, pow(AirMass(90.0 - e), 0.678));
+      }
+    }
+
+    double operator()(double elevation) const
+    {
+      double u = elevation * STEPS_PER_DEGREE;
+      std::size_t i = static_cast<std::size_t>(u);
+      return table_[i] + (u - i) * (table_[i + 1] - table_[i]);
+    }
+
+  private:
+    std::vector<double> table_;
+  };
+
+  const Transmittance &GetTransmittance()
+  {
+    static const Transmittance table;
+    return table;
+  }
+}
+
+int SPAYieldSim::Run(const std::vector<YieldSite> &sites, std::vector<YieldResult> *out)
+{
+  out->assign(sites.size(), YieldResult());
+
+  double perDay = 86400.0 / config_.step;
+  if (!(config_.step > 0.0) || perDay < 1.0)
+    return -1;
+  samplesPerDay_ = static_cast<std::size_t>(floor(perDay + 1e-9));
+
+  days_.clear();
+  for (Date d(config_.year, 1, 1); d.year == config_.year; d = d.NextDay())
+    days_.push_back(Day(d));
+  vectors_.resize(days_.size() * samplesPerDay_);
+
+  // Geocentric terms do not depend on the site: build them against a neutral one
+  SPALib reference(SiteData(Position(), WeatherData(10.0, 1010.0, 0.0)), config_.tier);
+  std::atomic<int> error(0);
+  pool_.ParallelFor(days_.size(), 1, [&](std::size_t begin, std::size_t end, unsigned) {
+    for (std::size_t d = begin; d < end; d++)
+    {
+      int result = BuildDay(reference, d);
+      if (result != 0)
+        error = result;
+    }
+  });
+  if (error != 0)
+    return error;
+
+  std::vector<SPALib> engines;
+  engines.reserve(sites.size());
+  scale_.resize(sites.size());
+  DateTimeData yearStart(days_[0].date, Time(0, 0, 0, 0.0));
+  for (std::size_t s = 0; s < sites.size(); s++)
+  {
+    double jd, deltaT;
+    engines.push_back(SPALib(sites[s].site, config_.tier));
+    (*out)[s].errCode = engines[s].GetJulianDay(yearStart, &jd, &deltaT);
+    scale_[s] = sites[s].aperture * sites[s].efficiency;
+  }
+
+  const std::size_t dayCount = days_.size();
+  cells_.assign(sites.size() * dayCount, Cell());
+  pool_.ParallelFor(cells_.size(), GRAIN, [&](std::size_t begin, std::size_t end, unsigned) {
+    for (std::size_t i = begin; i < end; i++)
+    {
+      std::size_t s = i / dayCount;
+      if ((*out)[s].errCode == 0)
+        SimulateDay(engines[s], sites[s].site.pos.Altitude, i % dayCount, &cells_[i]);
+    }
+  });
+
+  for (std::size_t s = 0; s < sites.size(); s++)
+  {
+    YieldResult &r = (*out)[s];
+    for (std::size_t d = 0; d < dayCount; d++)
+    {
+      const Cell &c = cells_[s * dayCount + d];
+      r.trackedEnergy += c.tracked;
+      r.incidentEnergy += c.incident;
+      r.sunHours += c.sunSeconds;
+    }
+    r.trackedEnergy *= scale_[s] / 1000.0;
+    r.incidentEnergy *= scale_[s] / 1000.0;
+    r.sunHours /= 3600.0;
+  }
+  return 0;
+}
+
+double SPAYieldSim::GetDayTracked(std::size_t site, std::size_t day) const
+{
+  return cells_[site * days_.size() + day].tracked * scale_[site] / 1000.0;
+}
+
+double SPAYieldSim::GetDayIncident(std::size_t site, std::size_t day) const
+{
+  return cells_[site * days_.size() + day].incident * scale_[site] / 1000.0;
+}
+
+int SPAYieldSim::BuildDay(const SPALib &engine, std::size_t day)
+{
+  SPAEphemeris ephemeris(engine);
+  int result = ephemeris.Build(DateTimeData(days_[day].date, Time(0, 0, 0, 0.0)), 1.0);
+  if (result != 0)
+    return result;
+
+  const double stepDays = config_.step / 86400.0;
+  Day &d = days_[day];
+  d.jd0 = ephemeris.GetStartJd() + 0.5 * stepDays;
+
+  SunNode node;
+  SunVector *v = &vectors_[day * samplesPerDay_];
+  for (std::size_t k = 0; k < samplesPerDay_; k++)
+  {
+    double jd = d.jd0 + k * stepDays;
+    ephemeris.GetSunNode(jd, &node);
+    SPALib::GetSunVector(jd, node, &v[k]);
+  }
+
+  // Sun distance at midday from the parallax, xi = 8.794" / r
+  ephemeris.GetSunNode(ephemeris.GetStartJd() + 0.5, &node);
+  double r = 8.794 / (3600.0 * node.xi);
+  d.irradiance = SOLAR_CONSTANT / (r * r);
+  return 0;
+}
+
+void SPAYieldSim::SimulateDay(const SPALib &engine, double altitude, std::size_t day,
+                              Cell *cell) const
+{
+  const SunVector *v = &vectors_[day * samplesPerDay_];
+  const double i0 = days_[day].irradiance;
+  const double h = fmax(altitude, 0.0); // km, Laue's correction is for sites above sea level
+
+  const Transmittance &transmittance = GetTransmittance();
+  double tracked = 0.0, incident = 0.0;
+  std::size_t up = 0;
+  for (std::size_t k = 0; k < samplesPerDay_; k++)
+  {
+    if (engine.GetElevationSine(v[k]) < HORIZON_SINE)
+      continue;
+
+    double cosInc;
+    double e = engine.GetElevation(v[k], &cosInc);
+    if (e <= 0.0)
+      continue;
+
+    double beam = i0 * ((1.0 - 0.14 * h) * transmittance(fmin(e, 90.0)) + 0.14 * h);
+    tracked += beam;
+    if (cosInc > 0.0)
+      incident += beam * cosInc;
+    up++;
+  }
+
+  const double hours = config_.step / 3600.0;
+  cell->tracked = tracked * hours;
+  cell->incident = incident * hours;
+  cell->sunSeconds = up * config_.step;
+}
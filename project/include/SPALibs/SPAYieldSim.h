@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "SPALib.h"
+#include "SPAWorkPool.h"
+
+/*************************** USER INPUT DATA ***************************************/
+struct YieldSite
+{
+  SiteData site;     // Location, weather for refraction, and the dish slope/azmRotation
+  double aperture;   // Collector aperture area [m^2]
+  double efficiency; // Optical x receiver efficiency [0..1]
+  YieldSite(const SiteData &s, const double &a = 1.0, const double &e = 1.0)
+      : site(s), aperture(a), efficiency(e) {}
+};
+
+struct YieldConfig
+{
+  int year;         // Calendar year simulated (UT days)
+  double step;      // Time step [s], samples sit at the middle of each step
+  int tier;         // SPATIER used for the geocentric terms
+  unsigned threads; // Worker threads, 0 for all cores
+  YieldConfig(const int &y, const double &s = 60.0, const int &t = SPA_TIER_EXACT,
+              const unsigned &n = 0)
+      : year(y), step(s), tier(t), threads(n) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+struct YieldResult
+{
+  int errCode;           /* spa_calculate() error code for the site, 0 on success */
+  double trackedEnergy;  // Two-axis tracking: clear-sky DNI on the aperture [kWh]
+  double incidentEnergy; // Dish held at slope/azmRotation: DNI * cos(incidence) [kWh]
+  double sunHours;       // Hours with the apparent sun above the horizon
+  YieldResult() : errCode(0), trackedEnergy(0.0), incidentEnergy(0.0), sunHours(0.0) {}
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/**
+ * @brief: Annual energy yield of many candidate sites / dish geometries under a clear
+ *         sky (Meinel beam model with Laue's altitude correction). Two passes over an
+ *         SPAWorkPool: first one ephemeris per UT day, geocentric nodes plus the
+ *         Earth-fixed sun vector of every step, shared by all sites; then one task per
+ *         (site, day) that only runs the per-site topocentric stage, skipping night
+ *         steps with a horizon test.
+ */
+class SPAYieldSim
+{
+public:
+  explicit SPAYieldSim(const YieldConfig &config) : config_(config), pool_(config.threads) {}
+
+  /**
+   * @brief: Simulate every site, one result per site in out. Returns -1 for a step
+   *         that does not fit a day, otherwise the error code of the year's ephemeris.
+   */
+  int Run(const std::vector<YieldSite> &sites, std::vector<YieldResult> *out);
+
+  /* Daily breakdown of the last Run() [kWh], two-axis tracked / fixed dish */
+  double GetDayTracked(std::size_t site, std::size_t day) const;
+  double GetDayIncident(std::size_t site, std::size_t day) const;
+  std::size_t GetDayCount() const { return days_.size(); }
+
+  const SPAWorkPool &GetPool() const { return pool_; }
+
+private:
+  struct Day
+  {
+    Date date;
+    double jd0;        // Julian day (UT) of the day's first sample
+    double irradiance; // Extraterrestrial beam at the day's sun distance [W/m^2]
+    Day(const Date &d) : date(d), jd0(0.0), irradiance(0.0) {}
+  };
+
+  struct Cell
+  {
+    double tracked;    // [Wh/m^2]
+    double incident;   // [Wh/m^2]
+    double sunSeconds;
+  };
+
+  int BuildDay(const SPALib &engine, std::size_t day);
+  void SimulateDay(const SPALib &engine, double altitude, std::size_t day, Cell *cell) const;
+
+  YieldConfig config_;
+  SPAWorkPool pool_;
+  std::size_t samplesPerDay_;
+  std::vector<Day> days_;
+  std::vector<SunVector> vectors_; // samplesPerDay_ per day
+  std::vector<Cell> cells_;        // days_.size() per site
+  std::vector<double> scale_;      // aperture * efficiency per site [m^2]
+};
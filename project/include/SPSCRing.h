@@ -0,0 +1,117 @@
+#pragma once
+#include <string.h>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @brief: Wait-free single-producer/single-consumer ring of trivially copyable items.
+ *         Capacity must be a power of two. Indices run free and are masked on access.
+ *         The producer never waits for the consumer: a push into a full ring overwrites
+ *         the oldest item, so the consumer always finds the newest ones. Each slot is a
+ *         seqlock: the producer marks it odd while writing item i and 2i + 2 once done,
+ *         and the consumer only keeps a copy whose sequence read 2i + 2 before and after
+ *         the copy. Items are held in atomic words, so a copy racing a rewrite is
+ *         discarded, never undefined. The consumer counts the items it lost that way, or
+ *         by falling a full ring behind, as overruns.
+ */
+template <typename T, std::size_t Capacity>
+class SPSCRing
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value, "Items are copied as raw words");
+
+public:
+  SPSCRing() : head_(0), overruns_(0), tail_(0)
+  {
+    for (Slot &slot : slots_)
+      slot.sequence.store(0, std::memory_order_relaxed);
+  }
+
+  SPSCRing(const SPSCRing &) = delete;
+  SPSCRing &operator=(const SPSCRing &) = delete;
+
+  /* Producer only. Overwrites the oldest item when the ring is full. */
+  void Push(const T &item)
+  {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    Slot &slot = slots_[head & (Capacity - 1)];
+    Word words[WORDS] = {};
+    memcpy(words, &item, sizeof(T));
+
+    slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // Odd mark before any word
+    for (std::size_t k = 0; k < WORDS; k++)
+      slot.words[k].store(words[k], std::memory_order_relaxed);
+    slot.sequence.store(2 * head + 2, std::memory_order_release);
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief: Consumer only. Empty the ring, copying the newest min(available, max) items
+   *         into out[] oldest first; older ones are discarded. Returns the number copied.
+   */
+  std::size_t DrainLatest(T *out, std::size_t max)
+  {
+    std::size_t head = head_.load(std::memory_order_acquire);
+    std::size_t tail = tail_;
+    if (head == tail)
+      return 0;
+
+    std::size_t lost = 0;
+    if (head - tail > Capacity)
+    {
+      // Lapped: the producer has already reused the slots of the oldest items
+      lost = head - Capacity - tail;
+      tail = head - Capacity;
+    }
+    std::size_t first = head - tail > max ? head - max : tail;
+    std::size_t n = 0;
+    for (std::size_t i = first; i != head; i++)
+    {
+      if (Load(i, &out[n]))
+        n++;
+      else
+        lost++;
+    }
+    tail_ = head;
+    if (lost > 0)
+      overruns_.store(overruns_.load(std::memory_order_relaxed) + lost, std::memory_order_relaxed);
+    return n;
+  }
+
+  /* Items overwritten by the producer before the consumer got to them */
+  std::size_t GetOverruns() const { return overruns_.load(std::memory_order_relaxed); }
+
+private:
+  typedef std::size_t Word; // Lock-free on every target
+  static const std::size_t WORDS = (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+  struct Slot
+  {
+    std::atomic<std::size_t> sequence; // 2i + 1 while item i is written, 2i + 2 once it is
+    std::atomic<Word> words[WORDS];
+  };
+
+  /* Copy of item index, false once the producer has started to reuse its slot */
+  bool Load(std::size_t index, T *out) const
+  {
+    const Slot &slot = slots_[index & (Capacity - 1)];
+    std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != 2 * index + 2)
+      return false;
+    Word words[WORDS];
+    for (std::size_t k = 0; k < WORDS; k++)
+      words[k] = slot.words[k].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire); // Words before the second look
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+      return false;
+    memcpy(out, words, sizeof(T));
+    return true;
+  }
+
+  alignas(64) std::atomic<std::size_t> head_; // Written by the producer
+  alignas(64) std::atomic<std::size_t> overruns_; // Written by the consumer
+  std::size_t tail_;                               // Consumer only
+  alignas(64) Slot slots_[Capacity];
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <time.h>
+#include <cstddef>
+
+/* CLOCK_MONOTONIC time [s], the time base of every sensor sample */
+inline double MonotonicNow()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* A sensor reading and the CLOCK_MONOTONIC time it was taken [s] */
+template <typename T>
+struct Timestamped
+{
+  double time;
+  T data;
+  Timestamped() : time(0.0), data() {}
+  Timestamped(const double &t, const T &d) : time(t), data(d) {}
+};
+
+/* Non-owning view of contiguous samples (C++14 has no std::span) */
+template <typename T>
+struct SampleSpan
+{
+  T *data;
+  std::size_t size;
+  SampleSpan() : data(nullptr), size(0) {}
+  SampleSpan(T *d, const std::size_t &n) : data(d), size(n) {}
+  T *begin() const { return data; }
+  T *end() const { return data + size; }
+  T &operator[](std::size_t i) const { return data[i]; }
+};
+
+/**
+ * @brief: Copy the newest samples of a driver view into a caller-owned span, oldest
+ *         first. Returns the number copied: min(view.size, out.size).
+ */
+template <typename T>
+std::size_t CopyLatest(const SampleSpan<const Timestamped<T>> &view, const SampleSpan<Timestamped<T>> &out)
+{
+  std::size_t n = view.size < out.size ? view.size : out.size;
+  const Timestamped<T> *src = view.data + (view.size - n);
+  for (std::size_t i = 0; i < n; i++)
+    out.data[i] = src[i];
+  return n;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <errno.h>
+#include <time.h>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include "SPSCRing.h"
+#include "SensorSample.h"
+
+/**
+ * @brief: Reads one sensor at a fixed rate on its own thread (absolute CLOCK_MONOTONIC
+ *         deadlines) and pushes its timestamped samples into an SPSCRing, so a slow or
+ *         blocking driver never stalls the control loop. read() is a batch read: it
+ *         returns the driver's view of everything captured since the previous call
+ *         (e.g. IMUSensor::GetIMUSamples()), one call per period however many samples. The loop is the single consumer:
+ *         DrainLatest() takes the newest samples without locking. A drain that finds
+ *         nothing new counts an underrun; samples a full ring overwrote before they
+ *         were drained count as overruns.
+ *         read() runs only on the sampling thread once Start() has been called.
+ */
+template <typename T, std::size_t Capacity = 64>
+class SensorSampler
+{
+public:
+  typedef SampleSpan<const Timestamped<T>> View;
+
+  SensorSampler(std::function<View()> read, double rate)
+      : read_(read), rate_(rate), running_(false), samples_(0), underruns_(0) {}
+  ~SensorSampler() { Stop(); }
+
+  SensorSampler(const SensorSampler &) = delete;
+  SensorSampler &operator=(const SensorSampler &) = delete;
+
+  /* Returns false for a non-positive rate or when already running */
+  bool Start()
+  {
+    if (rate_ <= 0.0 || running_)
+      return false;
+    running_ = true;
+    thread_ = std::thread(&SensorSampler::Sample, this);
+    return true;
+  }
+
+  void Stop()
+  {
+    running_ = false;
+    if (thread_.joinable())
+      thread_.join();
+  }
+
+  /* Consumer side, see SPSCRing::DrainLatest() */
+  std::size_t DrainLatest(Timestamped<T> *out, std::size_t max)
+  {
+    std::size_t n = ring_.DrainLatest(out, max);
+    if (n == 0)
+      underruns_++;
+    return n;
+  }
+
+  std::size_t GetSamples() const { return samples_.load(std::memory_order_relaxed); }
+  std::size_t GetOverruns() const { return ring_.GetOverruns(); }
+  std::size_t GetUnderruns() const { return underruns_; }
+
+private:
+  void Sample()
+  {
+    const long period = static_cast<long>(1e9 / rate_);
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    while (running_.load(std::memory_order_relaxed))
+    {
+      View view = read_();
+      for (const Timestamped<T> &s : view)
+        ring_.Push(s);
+      samples_.store(samples_.load(std::memory_order_relaxed) + view.size, std::memory_order_relaxed);
+
+      // Next deadline still ahead; a late read does not cause a burst of catch-up reads
+      double now = MonotonicNow();
+      do
+      {
+        deadline.tv_nsec += period;
+        while (deadline.tv_nsec >= 1000000000L)
+        {
+          deadline.tv_nsec -= 1000000000L;
+          deadline.tv_sec++;
+        }
+      } while (deadline.tv_sec + deadline.tv_nsec * 1e-9 < now);
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+        ;
+    }
+  }
+
+  std::function<View()> read_;
+  double rate_;
+  std::atomic<bool> running_;
+  std::atomic<std::size_t> samples_;
+  std::size_t underruns_; // Consumer thread only
+  std::thread thread_;
+  SPSCRing<Timestamped<T>, Capacity> ring_;
+};
@@ -1,4 +1,6 @@
 #include "WMMLib.h"
+#include <vector>
+#include "Probe.h"
 
 /**
  *
@@ -19,8 +21,19 @@ static int MAG_Grid(MAGtype_CoordGeodetic CoordData,
                     MAGtype_Date DateTime,
                     struct DecData *RecValue);
 
+static int MAG_Point(MAGtype_CoordGeodetic CoordData,
+                     MAGtype_MagneticModel *MagneticModel,
+                     MAGtype_MagneticModel *TimedMagneticModel,
+                     MAGtype_LegendreFunction *LegendreFunction,
+                     MAGtype_SphericalHarmonicVariables *SphVariables,
+                     MAGtype_Geoid *Geoid,
+                     MAGtype_Ellipsoid Ellip,
+                     MAGtype_Date DateTime,
+                     struct DecData *RecValue);
+
 DecData getDeclinition(const InData *input)
 {
+  PROBE_SCOPE(PROBE_DECLINATION);
   DecData decvalue;
   decvalue.errCode = NOERROR;
 
@@ -72,7 +85,112 @@ DecData getDeclinition(const InData *input)
   return decvalue;
 }
 
+WMMEngine::WMMEngine(const char *cofFile)
+    : errCode_(NOERROR), model_(NULL), timedModel_(NULL), legendre_(NULL), sphVariables_(NULL),
+      memoValid_(false)
+{
+  MAGtype_MagneticModel *MagneticModels[1];
+  std::vector<char> filename(cofFile, cofFile + strlen(cofFile) + 1);
+
+  if (!MAG_robustReadMagModels(filename.data(), &MagneticModels, 1))
+  {
+    errCode_ = FILEERROR;
+    return;
+  }
+  model_ = MagneticModels[0];
+
+  int NumTerms = ((model_->nMax + 1) * (model_->nMax + 2) / 2);
+  timedModel_ = MAG_AllocateModelMemory(NumTerms);
+  legendre_ = MAG_AllocateLegendreFunctionMemory(NumTerms);
+  sphVariables_ = MAG_AllocateSphVarMemory(model_->nMax);
+  if (!timedModel_ || !legendre_ || !sphVariables_)
+  {
+    errCode_ = MEMERROR;
+    return;
+  }
+
+  MAG_SetDefaults(&ellip_, &geoid_);
+
+  /* Set EGM96 Geoid parameters, heights are above Mean Sea Level */
+  geoid_.GeoidHeightBuffer = GeoidHeightBuffer;
+  geoid_.Geoid_Initialized = 1;
+  geoid_.UseGeoid = 1;
+}
+
+WMMEngine::~WMMEngine()
+{
+  if (model_)
+    MAG_FreeMagneticModelMemory(model_);
+  if (timedModel_)
+    MAG_FreeMagneticModelMemory(timedModel_);
+  if (legendre_)
+    MAG_FreeLegendreMemory(legendre_);
+  if (sphVariables_)
+    MAG_FreeSphVarMemory(sphVariables_);
+}
+
+DecData WMMEngine::GetDeclination(const InData &input)
+{
+  PROBE_SCOPE(PROBE_WMM);
+  std::lock_guard<std::mutex> hold(lock_);
+  if (memoValid_ && input.decimalYear == memoIn_.decimalYear &&
+      input.pos.Latitude == memoIn_.pos.Latitude &&
+      input.pos.Longitude == memoIn_.pos.Longitude &&
+      input.pos.Altitude == memoIn_.pos.Altitude)
+  {
+    PROBE_COUNT(COUNTER_WMM_MEMO, 1);
+    return memoOut_;
+  }
+
+  DecData decvalue;
+  decvalue.errCode = errCode_;
+  if (errCode_ != NOERROR)
+    return decvalue;
+
+  MAGtype_CoordGeodetic cood;
+  cood.phi = input.pos.Latitude;
+  cood.lambda = input.pos.Longitude;
+  cood.HeightAboveGeoid = input.pos.Altitude;
+
+  MAGtype_Date startdate;
+  startdate.DecimalYear = input.decimalYear;
+
+  if (!MAG_Point(cood, model_, timedModel_, legendre_, sphVariables_, &geoid_, ellip_, startdate,
+                 &decvalue) &&
+      decvalue.errCode == NOERROR)
+    decvalue.errCode = INPUTERROR; // Height outside the model's range
+
+  memoValid_ = true;
+  memoIn_ = input;
+  memoOut_ = decvalue;
+  return decvalue;
+}
+
 static int MAG_Grid(MAGtype_CoordGeodetic CoordData, MAGtype_MagneticModel *MagneticModel, MAGtype_Geoid *Geoid, MAGtype_Ellipsoid Ellip, MAGtype_Date DateTime, struct DecData *RecValue)
+{
+  int NumTerms, result;
+
+  MAGtype_MagneticModel *TimedMagneticModel;
+  MAGtype_SphericalHarmonicVariables *SphVariables;
+  MAGtype_LegendreFunction *LegendreFunction;
+
+  NumTerms = ((MagneticModel->nMax + 1) * (MagneticModel->nMax + 2) / 2);
+  TimedMagneticModel = MAG_AllocateModelMemory(NumTerms);
+  LegendreFunction = MAG_AllocateLegendreFunctionMemory(NumTerms); /* For storing the ALF functions */
+  SphVariables = MAG_AllocateSphVarMemory(MagneticModel->nMax);
+
+  result = MAG_Point(CoordData, MagneticModel, TimedMagneticModel, LegendreFunction, SphVariables,
+                     Geoid, Ellip, DateTime, RecValue);
+
+  /* Deallocate Memory */
+  MAG_FreeMagneticModelMemory(TimedMagneticModel);
+  MAG_FreeLegendreMemory(LegendreFunction);
+  MAG_FreeSphVarMemory(SphVariables);
+
+  return result;
+} /*MAG_Grid*/
+
+static int MAG_Point(MAGtype_CoordGeodetic CoordData, MAGtype_MagneticModel *MagneticModel, MAGtype_MagneticModel *TimedMagneticModel, MAGtype_LegendreFunction *LegendreFunction, MAGtype_SphericalHarmonicVariables *SphVariables, MAGtype_Geoid *Geoid, MAGtype_Ellipsoid Ellip, MAGtype_Date DateTime, struct DecData *RecValue)
 {
   // Check DateTime is within Model Validity
   if (DateTime.DecimalYear < MagneticModel->min_year || DateTime.DecimalYear > MagneticModel->CoefficientFileEndDate)
@@ -81,23 +199,13 @@ static int MAG_Grid(MAGtype_CoordGeodetic CoordData, MAGtype_MagneticModel *Magn
     return FALSE;
   }
 
-  int NumTerms;
-
-  MAGtype_MagneticModel *TimedMagneticModel;
   MAGtype_CoordSpherical CoordSpherical;
   MAGtype_MagneticResults MagneticResultsSph, MagneticResultsGeo, MagneticResultsSphVar, MagneticResultsGeoVar;
-  MAGtype_SphericalHarmonicVariables *SphVariables;
   MAGtype_GeoMagneticElements GeoMagneticElements, Errors;
-  MAGtype_LegendreFunction *LegendreFunction;
 
   double min_wgsalt = -1;
   double max_wgsalt = 1900;
 
-  NumTerms = ((MagneticModel->nMax + 1) * (MagneticModel->nMax + 2) / 2);
-  TimedMagneticModel = MAG_AllocateModelMemory(NumTerms);
-  LegendreFunction = MAG_AllocateLegendreFunctionMemory(NumTerms); /* For storing the ALF functions */
-  SphVariables = MAG_AllocateSphVarMemory(MagneticModel->nMax);
-
   if (Geoid->UseGeoid == 1)
     MAG_ConvertGeoidToEllipsoidHeight(&CoordData, Geoid); /* This converts the height above mean sea level to height above the WGS-84 ellipsoid */
   else
@@ -128,10 +236,10 @@ static int MAG_Grid(MAGtype_CoordGeodetic CoordData, MAGtype_MagneticModel *Magn
 
   MagComponents res, er;
   // Pass Value Result
+  res.F = GeoMagneticElements.F;
   /**
    * @brief: Usage not yet defined for application
    *
-  res.F = GeoMagneticElements.F;
   res.H = GeoMagneticElements.H;
   res.X = GeoMagneticElements.X;
   res.Y = GeoMagneticElements.Y;
@@ -140,10 +248,10 @@ static int MAG_Grid(MAGtype_CoordGeodetic CoordData, MAGtype_MagneticModel *Magn
   res.D = GeoMagneticElements.Decl;
 
   // Pass Error Result
+  er.F = Errors.F;
   /**
    * @brief: Usage not yet defined for application
    *
-  er.F = Errors.F;
   er.H = Errors.H;
   er.X = Errors.X;
   er.Y = Errors.Y;
@@ -154,12 +262,7 @@ static int MAG_Grid(MAGtype_CoordGeodetic CoordData, MAGtype_MagneticModel *Magn
   RecValue->magData = res;
   RecValue->magDataErr = er;
 
-  /* Deallocate Memory */
-  MAG_FreeMagneticModelMemory(TimedMagneticModel);
-  MAG_FreeLegendreMemory(LegendreFunction);
-  MAG_FreeSphVarMemory(SphVariables);
-
   RecValue->errCode = NOERROR;
 
   return TRUE;
-} /*MAG_Grid*/
+} /*MAG_Point*/
@@ -1,4 +1,5 @@
 #pragma once
+#include <mutex>
 #include "IDateTime.h"
 #include "IMUSensor.h"
 #include "IGPSSensor.h"
@@ -22,10 +23,10 @@ enum ERROCODE
 };
 struct MagComponents
 {
+  double F; // Total Intensity of the geomagnetic field (nT)
   /**
    * @brief: Usage not yet defined for application
    *
-  double F; // Total Intensity of the geomagnetic field
   double H; // Horizontal Intensity of the geomagnetic field
   double X; // North Component of the geomagnetic field
   double Y; // East Component of the geomagnetic field
@@ -62,4 +63,40 @@ extern "C"
 
 #ifdef __cplusplus
 } // extern "C"
-#endif
\ No newline at end of file
+#endif
+
+/**
+ * @brief: getDeclinition() for long-running callers. WMM.COF is parsed and the
+ *         spherical harmonic work buffers are allocated once, at construction; the
+ *         last result is kept, so repeating the same input (a fixed tracker asking
+ *         once per tick) costs a comparison. Calls are serialised, so one engine can
+ *         serve the trackers of a whole fleet.
+ */
+class WMMEngine
+{
+public:
+  explicit WMMEngine(const char *cofFile = "WMM.COF");
+  ~WMMEngine();
+
+  WMMEngine(const WMMEngine &) = delete;
+  WMMEngine &operator=(const WMMEngine &) = delete;
+
+  /* NOERROR, or FILEERROR when the coefficient file could not be read */
+  int GetErrCode() const { return errCode_; }
+
+  DecData GetDeclination(const InData &input);
+
+private:
+  int errCode_;
+  MAGtype_MagneticModel *model_;
+  MAGtype_MagneticModel *timedModel_;
+  MAGtype_LegendreFunction *legendre_;
+  MAGtype_SphericalHarmonicVariables *sphVariables_;
+  MAGtype_Ellipsoid ellip_;
+  MAGtype_Geoid geoid_;
+
+  std::mutex lock_;
+  bool memoValid_;
+  InData memoIn_;
+  DecData memoOut_;
+};
@@ -0,0 +1,137 @@
+#include "CoreBenchmark.h"
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "FleetController.h"
+#include "TrackingCore.h"
+
+namespace
+{
+  /* What a board build looks like: one concrete driver per interface, declared final */
+  class StubIMU final : public IMUSensor
+  {
+  };
+  class StubGPS final : public IGPSSensor
+  {
+  };
+  class StubWeather final : public IWeather
+  {
+  };
+  class StubActuator final : public IActuator
+  {
+  };
+
+  struct CoreCost
+  {
+    int errCode;
+    double step;    // Full Step() [ns]
+    double heading; // ReadSensors() + UpdateHeading() [ns]
+  };
+
+  template <typename Core>
+  CoreCost Measure(Core &core, std::size_t steps)
+  {
+    CoreCost cost = {0, 0.0, 0.0};
+    core.SetGate(GateConfig(-90.0)); // Always open: time the tracking path, day or night
+    cost.errCode = core.Step(); // Priming: seeds the filter, fetches the declination, builds the engine
+    if (cost.errCode != 0)
+      return cost;
+
+    double t0 = MonotonicNow();
+    for (std::size_t i = 0; i < steps && cost.errCode == 0; i++)
+      cost.errCode = core.Step();
+    double t1 = MonotonicNow();
+    for (std::size_t i = 0; i < steps && cost.errCode == 0; i++)
+    {
+      core.ReadSensors();
+      cost.errCode = core.UpdateHeading();
+    }
+    double t2 = MonotonicNow();
+    cost.step = (t1 - t0) * 1e9 / steps;
+    cost.heading = (t2 - t1) * 1e9 / steps;
+    return cost;
+  }
+
+  /* Kept out of line so the interface references are all the loop sees */
+  __attribute__((noinline)) CoreCost MeasureVirtual(IMUSensor &imu, IGPSSensor &gps, IWeather &weather,
+                                                    const HighResClock &clock, IActuator &actuator,
+                                                    WMMEngine &wmm, std::size_t steps)
+  {
+    TrackingCore<IMUSensor, IGPSSensor, IWeather, HighResClock, IActuator> core(imu, gps, weather, clock,
+                                                                                 actuator, wmm);
+    return Measure(core, steps);
+  }
+
+  void Print(const char *name, const CoreCost &cost)
+  {
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+              << " step " << std::setw(9) << cost.step << " ns, sensors + heading "
+              << std::setw(7) << cost.heading << " ns" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+  }
+} // namespace
+
+int RunCoreBenchmark(WMMEngine &wmm, std::size_t steps)
+{
+  if (steps == 0)
+    return INPUTERROR;
+
+  StubIMU imu;
+  StubGPS gps;
+  StubWeather weather;
+  StubActuator actuator;
+  HighResClock clock;
+
+  TrackingCore<StubIMU, StubGPS, StubWeather, HighResClock, StubActuator> direct(imu, gps, weather, clock,
+                                                                                 actuator, wmm);
+  CoreCost bound = Measure(direct, steps);
+  if (bound.errCode != 0)
+    return bound.errCode;
+  CoreCost dispatched = MeasureVirtual(imu, gps, weather, clock, actuator, wmm, steps);
+  if (dispatched.errCode != 0)
+    return dispatched.errCode;
+
+  std::cout << "TrackingCore, " << steps << " steps" << std::endl;
+  Print("static", bound);
+  Print("virtual", dispatched);
+  return 0;
+}
+
+int RunFleetBenchmark(WMMEngine &wmm, std::size_t trackers, unsigned threads, std::size_t ticks)
+{
+  if (trackers == 0 || ticks == 0)
+    return INPUTERROR;
+
+  std::vector<IMUSensor> imus(trackers);
+  std::vector<IGPSSensor> gpss(trackers);
+  std::vector<IWeather> weathers(trackers);
+  std::vector<IActuator> actuators(trackers);
+  // Polling, no deadband: every tracker steps on every tick
+  FleetController fleet(FleetConfig(1.0, 0.0, 0.0, threads, 16, 0.1, 0.0), wmm);
+  for (std::size_t i = 0; i < trackers; i++)
+    fleet.AddTracker(imus[i], gpss[i], weathers[i], actuators[i]);
+  fleet.SetGate(GateConfig(-90.0));
+
+  int errCode = fleet.Tick(MonotonicNow()); // Priming: engines, declinations, filters
+  double t0 = MonotonicNow();
+  for (std::size_t i = 0; i < ticks && errCode == 0; i++)
+    errCode = fleet.Tick(MonotonicNow());
+  double t1 = MonotonicNow();
+  if (errCode != 0)
+    return errCode;
+  for (std::size_t i = 0; i < trackers; i++)
+  {
+    if (fleet.GetTrackerStats(i).errors > 0)
+      return fleet.GetTrackerStats(i).lastError;
+  }
+
+  double tick = (t1 - t0) / ticks;
+  std::cout << "FleetController, " << trackers << " trackers on " << fleet.GetThreadCount() << " threads, "
+            << ticks << " ticks" << std::endl;
+  std::cout << std::fixed << std::setprecision(1) << "tick " << std::setw(10) << tick * 1e6
+            << " us, per tracker step " << std::setw(7) << tick * 1e9 / trackers << " ns" << std::endl;
+  std::cout.unsetf(std::ios::floatfield);
+  std::cout << std::setprecision(6);
+  return 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include "WMMLib.h"
+
+/**
+ * @brief: Time TrackingCore over the stub sensors in its two forms: bound statically to
+ *         final driver types, and through the virtual interfaces. Prints the cost of a
+ *         full Step() and of the sensor-rate part (ReadSensors() + UpdateHeading()).
+ *         Returns 0 or the first error code of a step.
+ */
+int RunCoreBenchmark(WMMEngine &wmm, std::size_t steps);
+
+/**
+ * @brief: Time a polling FleetController of `trackers` stub trackers on `threads` workers
+ *         (0 for every hardware thread), gates held open so every tracker runs its full
+ *         step, day or night. Prints the tick and the cost per tracker step.
+ *         Returns 0 or the first error code of a tick or a tracker.
+ */
+int RunFleetBenchmark(WMMEngine &wmm, std::size_t trackers, unsigned threads, std::size_t ticks);
@@ -0,0 +1,245 @@
+#include "FleetController.h"
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+  const double NSEC = 1e9;
+  const double EPHEMERIS_SPAN = 2.0;   // Days of sun terms built at a time
+  const double EPHEMERIS_MARGIN = 1.0; // Rebuild once less than this is left ahead [days]
+
+  double ToSeconds(const struct timespec &ts)
+  {
+    return ts.tv_sec + ts.tv_nsec / NSEC;
+  }
+
+  void AddNanoseconds(struct timespec *ts, long long ns)
+  {
+    long long total = ts->tv_nsec + ns;
+    ts->tv_sec += static_cast<time_t>(total / static_cast<long long>(NSEC));
+    ts->tv_nsec = static_cast<long>(total % static_cast<long long>(NSEC));
+  }
+} // namespace
+
+FleetController::FleetController(const FleetConfig &config, WMMEngine &wmm)
+    : config_(config), wmm_(wmm), pool_(config.threads),
+      reference_(SiteData(Position(), WeatherData())), ephemeris_(reference_), stop_(false), ticks_(0),
+      missed_(0) {}
+
+std::size_t FleetController::AddTracker(IMUSensor &imu, IGPSSensor &gps, IWeather &weather,
+                                        IActuator &actuator, double deadline)
+{
+  if (deadline <= 0.0)
+    deadline = 1.0 / config_.rate;
+  trackers_.emplace_back(new Tracker(imu, gps, weather, actuator, fleetClock_, wmm_, config_, deadline));
+  Tracker &t = *trackers_.back();
+  t.core.SetEphemeris(&ephemeris_);
+  t.core.SetRtsCache(&rtsCache_);
+  if (config_.deadband > 0.0)
+    t.core.SetPlanner(&t.planner);
+  return trackers_.size() - 1;
+}
+
+void FleetController::SetTelemetry(TelemetryLog *telemetry)
+{
+  for (std::size_t i = 0; i < trackers_.size(); i++)
+    trackers_[i]->core.SetTelemetry(telemetry, static_cast<uint32_t>(i));
+}
+
+void FleetController::SetGate(const GateConfig &config)
+{
+  for (const std::unique_ptr<Tracker> &t : trackers_)
+    t->core.SetGate(config);
+}
+
+int FleetController::UpdateEphemeris(const ClockTime &now)
+{
+  // Between ticks only: the workers read the nodes without a lock
+  if (!ephemeris_.IsEmpty() && now.jdUtc >= ephemeris_.GetStartJd() &&
+      now.jdUtc + EPHEMERIS_MARGIN <= ephemeris_.GetEndJd())
+    return 0;
+  return ephemeris_.Build(now.local, EPHEMERIS_SPAN, EPHEMERIS_MARGIN / 4.0);
+}
+
+void FleetController::Step(Tracker &t, double due)
+{
+  int rc = t.core.Step();
+  double latency = MonotonicNow() - due;
+  TrackerStats &s = t.stats;
+  s.latency.Add(latency);
+  if (latency > t.deadline)
+  {
+    s.misses++;
+    PROBE_COUNT(COUNTER_MISSED, 1);
+  }
+  if (rc == 0)
+    s.steps++;
+  else if (rc == Core::NOTREADY)
+    s.notReady++;
+  else
+  {
+    s.errors++;
+    s.lastError = rc;
+  }
+  if (IsEventDriven())
+  {
+    // Not ready or failed: retry at the finest spacing
+    double now = fleetClock_.now.unixTime;
+    t.next = rc == 0 ? t.core.GetNextUpdate(config_.maxInterval) : now;
+    t.next = std::max(t.next, now + 1.0 / config_.rate);
+  }
+}
+
+int FleetController::Tick(double due)
+{
+  fleetClock_.now = clock_.Now();
+  int errCode = UpdateEphemeris(fleetClock_.now);
+  if (errCode != 0)
+    return errCode;
+
+  pool_.ParallelFor(trackers_.size(), config_.grain, [this, due](std::size_t begin, std::size_t end, unsigned) {
+    for (std::size_t i = begin; i < end; i++)
+      Step(*trackers_[i], due);
+  });
+  ticks_++;
+  return 0;
+}
+
+int FleetController::Wake(double due)
+{
+  fleetClock_.now = clock_.Now();
+  int errCode = UpdateEphemeris(fleetClock_.now);
+  if (errCode != 0)
+    return errCode;
+
+  due_.clear();
+  scheduler_.PopDue(fleetClock_.now.unixTime, &due_);
+  pool_.ParallelFor(due_.size(), config_.grain, [this, due](std::size_t begin, std::size_t end, unsigned) {
+    for (std::size_t k = begin; k < end; k++)
+      Step(*trackers_[due_[k]], due);
+  });
+  for (std::size_t i : due_)
+    scheduler_.Schedule(trackers_[i]->next, i);
+  ticks_++;
+  return 0;
+}
+
+int FleetController::Run()
+{
+  if (config_.rate <= 0.0 || config_.grain == 0 || trackers_.empty())
+    return INPUTERROR;
+  if (wmm_.GetErrCode() != NOERROR)
+    return wmm_.GetErrCode();
+  for (const std::unique_ptr<Tracker> &t : trackers_)
+  {
+    int errCode = t->imu.Initialize();
+    if (errCode == 0)
+      errCode = t->gps.Initialize();
+    if (errCode == 0)
+      errCode = t->actuator.Initialize();
+    if (errCode != 0)
+      return errCode;
+  }
+
+  const long long period = static_cast<long long>(NSEC / config_.rate);
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  const double start = ToSeconds(deadline);
+  double nextReport = start + config_.reportInterval;
+  std::size_t reported = 0;
+  int errCode = 0;
+
+  if (IsEventDriven())
+  {
+    // Everyone is due at once to begin with
+    const double now = clock_.Now().unixTime;
+    for (std::size_t i = 0; i < trackers_.size(); i++)
+      scheduler_.Schedule(now, i);
+  }
+
+  while (!stop_)
+  {
+    if (IsEventDriven())
+    {
+      // Wake-ups are kept in Unix time: sleep on the monotonic clock until the earliest
+      double wake = scheduler_.GetNextTime() - clock_.Now().unixTime + MonotonicNow();
+      if (config_.duration > 0.0)
+        wake = std::min(wake, start + config_.duration);
+      deadline.tv_sec = static_cast<time_t>(floor(wake));
+      deadline.tv_nsec = static_cast<long>((wake - floor(wake)) * NSEC);
+    }
+    int rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+    if (rc == EINTR)
+      continue;
+    if (stop_)
+      break;
+
+    const double due = ToSeconds(deadline);
+    errCode = IsEventDriven() ? Wake(due) : Tick(due);
+    if (errCode != 0)
+      break;
+    const double done = MonotonicNow();
+    tickStats_.Add(done - due);
+
+    AddNanoseconds(&deadline, period);
+    if (!IsEventDriven() && done > ToSeconds(deadline))
+    {
+      long long behind = static_cast<long long>((done - ToSeconds(deadline)) * NSEC);
+      long long skipped = behind / period + 1;
+      missed_ += static_cast<std::size_t>(skipped);
+      AddNanoseconds(&deadline, skipped * period);
+    }
+
+    if (config_.reportInterval > 0.0 && done >= nextReport)
+    {
+      Report();
+      reported = ticks_;
+      nextReport += config_.reportInterval * (floor((done - nextReport) / config_.reportInterval) + 1.0);
+    }
+    if (config_.duration > 0.0 && done - start >= config_.duration)
+      break;
+  }
+
+  if (reported != ticks_ || ticks_ == 0)
+    Report();
+  return errCode;
+}
+
+void FleetController::Report() const
+{
+  std::size_t steps = 0, notReady = 0, errors = 0, misses = 0, late = 0, failing = 0, moves = 0, asleep = 0;
+  double worst = 0.0, total = 0.0, rate = 0.0;
+  std::size_t samples = 0;
+  for (const std::unique_ptr<Tracker> &t : trackers_)
+  {
+    const TrackerStats &s = t->stats;
+    steps += s.steps;
+    notReady += s.notReady;
+    errors += s.errors;
+    misses += s.misses;
+    late += s.misses > 0;
+    failing += s.lastError != 0;
+    asleep += t->core.GetGateState() != GATE_TRACKING;
+    worst = std::max(worst, s.latency.max);
+    total += s.latency.total;
+    samples += s.latency.count;
+    moves += t->planner.GetStats().commands;
+    rate += t->planner.GetStats().GetCommandsPerHour();
+  }
+  double meanTick = tickStats_.count ? tickStats_.total / tickStats_.count : 0.0;
+  std::cout << "Trackers: " << trackers_.size() << ", Threads: " << pool_.GetThreadCount()
+            << (IsEventDriven() ? ", Wake-ups: " : ", Ticks: ") << ticks_ << ", Missed deadlines: " << missed_
+            << ", Steals: " << pool_.GetSteals() << std::endl;
+  std::cout << "  " << (IsEventDriven() ? "Wake-up" : "Tick") << " mean " << meanTick * 1e3 << " ms, max "
+            << tickStats_.max * 1e3 << " ms" << std::endl;
+  std::cout << "  Tracker steps: " << steps << ", not ready: " << notReady << ", errors: " << errors
+            << " (" << failing << " trackers), asleep: " << asleep << std::endl;
+  std::cout << "  Tracker latency mean " << (samples ? total / samples : 0.0) * 1e3 << " ms, max "
+            << worst * 1e3 << " ms, deadline misses: " << misses << " (" << late << " trackers)" << std::endl;
+  if (config_.deadband > 0.0)
+    std::cout << "  Moves: " << moves << " (" << (trackers_.empty() ? 0.0 : rate / trackers_.size())
+              << " per tracker per hour)" << std::endl;
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "HighResClock.h"
+#include "IActuator.h"
+#include "IGPSSensor.h"
+#include "IMUSensor.h"
+#include "IWeather.h"
+#include "MotionPlanner.h"
+#include "SPAEphemeris.h"
+#include "SPALib.h"
+#include "SPARtsCache.h"
+#include "SPAWorkPool.h"
+#include "TrackingCore.h"
+#include "TrackingDaemon.h"
+#include "UpdateScheduler.h"
+#include "WMMLib.h"
+
+/*************************** USER INPUT DATA ***************************************/
+struct FleetConfig
+{
+  double rate;           // Fleet tick rate [Hz]
+  double duration;       // Run time [s], 0 runs until Stop()
+  double reportInterval; // Seconds between reports, 0 for none
+  unsigned threads;      // Worker threads, 0 for every hardware thread
+  std::size_t grain;     // Trackers per work chunk
+  double fusionGain;     // Madgwick beta of every tracker [rad/s]
+  double deadband;       // MotionPlanner deadband of every tracker [degrees], 0 for none
+  double maxInterval;    // With a deadband: longest a tracker sleeps between steps [s], 0 polls
+  FleetConfig(const double &r = 1.0, const double &d = 0.0, const double &i = 60.0,
+              const unsigned &t = 0, const std::size_t &g = 16, const double &b = 0.1,
+              const double &db = 0.1, const double &mi = 60.0)
+      : rate(r), duration(d), reportInterval(i), threads(t), grain(g), fusionGain(b), deadband(db),
+        maxInterval(mi) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+struct TrackerStats
+{
+  std::size_t steps;    // Ticks that produced a command (or a planner decision)
+  std::size_t notReady; // Ticks without an orientation or a GPS fix yet
+  std::size_t errors;   // Ticks that ended in an error code
+  std::size_t misses;   // Ticks finished after the tracker's deadline
+  int lastError;        // Last error code, 0 for none
+  StageStats latency;   // Due time to end of the tracker's step [s]
+  TrackerStats() : steps(0), notReady(0), errors(0), misses(0), lastError(0) {}
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/* TrackingCore Clock policy: the fleet tick's time, read once and seen by every tracker */
+class FleetClock
+{
+public:
+  ClockTime Now() const { return now; }
+  ClockTime now;
+};
+
+/**
+ * @brief: Many trackers in one process. Each tick reads the clock once, then spreads the
+ *         trackers' steps (sensors, fusion, sun, planning, command) over an SPAWorkPool:
+ *         contiguous blocks per worker, stolen from when a worker runs dry. Everything
+ *         site independent is shared: one WMMEngine, and one SPAEphemeris of geocentric
+ *         sun terms that leaves each tracker only its topocentric stage. Each tracker
+ *         has its own deadline after the tick start and its own miss and latency count.
+ *         A tracker in error is counted and stepped again next tick; the fleet goes on.
+ *         Sensors are polled in the step: there are no sampler threads per tracker.
+ *
+ *         With a deadband and a maxInterval the fleet is event driven instead: after
+ *         each step a tracker asks its planner when the dish must next move (the end of
+ *         a move, or the predicted deadband crossing) and sleeps in an UpdateScheduler
+ *         until then. A wake-up steps only the trackers due, so the work follows the
+ *         number of moves, not trackers x rate; the rate is then only the finest
+ *         spacing between two steps of one tracker. Headings are refreshed at the
+ *         wake-ups (HeadingFusion reseeds over long gaps) and at least every maxInterval.
+ *         At night each tracker's gate (TrackingCore) stows the dish once; a polling
+ *         fleet still steps it, without SPA or commands, an event driven one leaves it
+ *         asleep until its sunrise. The gates solve their days on one shared SPARtsCache.
+ */
+class FleetController
+{
+public:
+  typedef TrackingCore<IMUSensor, IGPSSensor, IWeather, FleetClock, IActuator> Core;
+
+  FleetController(const FleetConfig &config, WMMEngine &wmm);
+
+  FleetController(const FleetController &) = delete;
+  FleetController &operator=(const FleetController &) = delete;
+
+  /**
+   * @brief: Add a tracker before Run(). deadline is the time after the tick start its
+   *         command must be out by [s], 0 for the tick period. Returns its index.
+   */
+  std::size_t AddTracker(IMUSensor &imu, IGPSSensor &gps, IWeather &weather, IActuator &actuator,
+                         double deadline = 0.0);
+
+  /* Log every tracker's ticks to one telemetry ring, tagged with the tracker index */
+  void SetTelemetry(TelemetryLog *telemetry);
+
+  /* Night gate of every tracker added so far, see TrackingCore::SetGate(); before Run() */
+  void SetGate(const GateConfig &config);
+
+  /* Run until the duration elapses or Stop() is called. Returns 0 or an error code. */
+  int Run();
+
+  /* One polling tick started at due (MonotonicNow() scale). Returns 0 or an SPA error code. */
+  int Tick(double due);
+
+  /* Event driven: step the trackers due by now. Returns 0 or an SPA error code. */
+  int Wake(double due);
+
+  /* Safe to call from a signal handler */
+  void Stop() { stop_ = true; }
+
+  std::size_t GetTrackerCount() const { return trackers_.size(); }
+  const TrackerStats &GetTrackerStats(std::size_t i) const { return trackers_[i]->stats; }
+  const Core &GetCore(std::size_t i) const { return trackers_[i]->core; }
+  const StageStats &GetTickStats() const { return tickStats_; }
+  unsigned GetThreadCount() const { return pool_.GetThreadCount(); }
+
+private:
+  struct Tracker
+  {
+    IMUSensor &imu;
+    IGPSSensor &gps;
+    IActuator &actuator;
+    Core core;
+    MotionPlanner planner;
+    double deadline;
+    double next; // Event driven: Unix time of the next step
+    TrackerStats stats;
+    Tracker(IMUSensor &i, IGPSSensor &g, IWeather &w, IActuator &a, const FleetClock &clock,
+            WMMEngine &wmm, const FleetConfig &config, double d)
+        : imu(i), gps(g), actuator(a), core(i, g, w, clock, a, wmm, config.fusionGain),
+          planner(PlannerConfig(config.deadband, 1.0 / config.rate)), deadline(d), next(0.0) {}
+  };
+
+  bool IsEventDriven() const { return config_.deadband > 0.0 && config_.maxInterval > 0.0; }
+  int UpdateEphemeris(const ClockTime &now);
+  void Step(Tracker &t, double due);
+  void Report() const;
+
+  FleetConfig config_;
+  WMMEngine &wmm_;
+  SPAWorkPool pool_;
+  HighResClock clock_;
+  FleetClock fleetClock_;
+  SPALib reference_; // Geocentric terms only: its site is a placeholder
+  SPAEphemeris ephemeris_;
+  SPARtsCache rtsCache_; // Shared by the trackers' night gates
+  std::vector<std::unique_ptr<Tracker>> trackers_;
+  UpdateScheduler scheduler_;
+  std::vector<std::size_t> due_;
+
+  std::atomic<bool> stop_;
+  std::size_t ticks_;  // Polling ticks or event wake-ups
+  std::size_t missed_; // Polling ticks that overran their period
+  StageStats tickStats_;
+};
@@ -0,0 +1,161 @@
+#include "HeadingFusion.h"
+#include <math.h>
+
+namespace
+{
+  const double RAD_TO_DEG = 57.29577951308232;
+
+  double Wrap360(double angle)
+  {
+    angle = fmod(angle, 360.0);
+    return angle < 0.0 ? angle + 360.0 : angle;
+  }
+} // namespace
+
+void HeadingFusion::Update(const IMUSensorData &sample, double dt)
+{
+  if (!seeded_ || dt <= 0.0 || dt > maxGap_)
+  {
+    seeded_ = Seed(sample);
+    return;
+  }
+
+  double q0 = q_.w, q1 = q_.x, q2 = q_.y, q3 = q_.z;
+  double gx = sample.gyro.X, gy = sample.gyro.Y, gz = sample.gyro.Z;
+  double ax = sample.accel.X, ay = sample.accel.Y, az = sample.accel.Z;
+  double mx = sample.mag.X, my = sample.mag.Y, mz = sample.mag.Z;
+
+  // Rate of change of the quaternion from the gyro
+  double qDot0 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
+  double qDot1 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
+  double qDot2 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
+  double qDot3 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+
+  double aNorm = ax * ax + ay * ay + az * az;
+  double mNorm = mx * mx + my * my + mz * mz;
+  if (aNorm > 0.0 && mNorm > 0.0)
+  {
+    double r = 1.0 / sqrt(aNorm);
+    ax *= r;
+    ay *= r;
+    az *= r;
+    r = 1.0 / sqrt(mNorm);
+    mx *= r;
+    my *= r;
+    mz *= r;
+
+    double _2q0mx = 2.0 * q0 * mx, _2q0my = 2.0 * q0 * my, _2q0mz = 2.0 * q0 * mz;
+    double _2q1mx = 2.0 * q1 * mx;
+    double _2q0 = 2.0 * q0, _2q1 = 2.0 * q1, _2q2 = 2.0 * q2, _2q3 = 2.0 * q3;
+    double _2q0q2 = 2.0 * q0 * q2, _2q2q3 = 2.0 * q2 * q3;
+    double q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+    double q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+    double q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+
+    // Field direction in the earth frame, folded onto the north/up plane
+    double hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 +
+                _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+    double hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 +
+                _2q2 * mz * q3 - my * q3q3;
+    double _2bx = sqrt(hx * hx + hy * hy);
+    double _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 +
+                  _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+    double _4bx = 2.0 * _2bx;
+    double _4bz = 2.0 * _2bz;
+
+    // Gradient of the accelerometer and magnetometer error functions
+    double ex = 2.0 * q1q3 - _2q0q2 - ax;
+    double ey = 2.0 * q0q1 + _2q2q3 - ay;
+    double ez = 1.0 - 2.0 * q1q1 - 2.0 * q2q2 - az;
+    double fx = _2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+    double fy = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+    double fz = _2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz;
+
+    double s0 = -_2q2 * ex + _2q1 * ey - _2bz * q2 * fx + (-_2bx * q3 + _2bz * q1) * fy + _2bx * q2 * fz;
+    double s1 = _2q3 * ex + _2q0 * ey - 4.0 * q1 * ez + _2bz * q3 * fx + (_2bx * q2 + _2bz * q0) * fy +
+                (_2bx * q3 - _4bz * q1) * fz;
+    double s2 = -_2q0 * ex + _2q3 * ey - 4.0 * q2 * ez + (-_4bx * q2 - _2bz * q0) * fx +
+                (_2bx * q1 + _2bz * q3) * fy + (_2bx * q0 - _4bz * q2) * fz;
+    double s3 = _2q1 * ex + _2q2 * ey + (-_4bx * q3 + _2bz * q1) * fx + (-_2bx * q0 + _2bz * q2) * fy +
+                _2bx * q1 * fz;
+    double sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if (sNorm > 0.0)
+    {
+      r = beta_ / sqrt(sNorm);
+      qDot0 -= r * s0;
+      qDot1 -= r * s1;
+      qDot2 -= r * s2;
+      qDot3 -= r * s3;
+    }
+  }
+
+  q0 += qDot0 * dt;
+  q1 += qDot1 * dt;
+  q2 += qDot2 * dt;
+  q3 += qDot3 * dt;
+  double r = 1.0 / sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+  q_ = Quaternion(q0 * r, q1 * r, q2 * r, q3 * r);
+}
+
+bool HeadingFusion::Seed(const IMUSensorData &sample)
+{
+  // Earth axes in the body frame: up from gravity, west = up x field, north = west x up
+  const Point3f &a = sample.accel;
+  const Point3f &m = sample.mag;
+  double wx = a.Y * m.Z - a.Z * m.Y;
+  double wy = a.Z * m.X - a.X * m.Z;
+  double wz = a.X * m.Y - a.Y * m.X;
+  double aNorm = sqrt(a.X * a.X + a.Y * a.Y + a.Z * a.Z);
+  double wNorm = sqrt(wx * wx + wy * wy + wz * wz);
+  if (aNorm == 0.0 || wNorm == 0.0)
+    return false; // No gravity, or field parallel to it: nothing to seed from
+  double ux = a.X / aNorm, uy = a.Y / aNorm, uz = a.Z / aNorm;
+  wx /= wNorm;
+  wy /= wNorm;
+  wz /= wNorm;
+  double nx = wy * uz - wz * uy;
+  double ny = wz * ux - wx * uz;
+  double nz = wx * uy - wy * ux;
+
+  // Rows of the body-to-earth rotation are the earth axes: convert (Shepperd)
+  double r00 = nx, r01 = ny, r02 = nz;
+  double r10 = wx, r11 = wy, r12 = wz;
+  double r20 = ux, r21 = uy, r22 = uz;
+  double trace = r00 + r11 + r22;
+  Quaternion q;
+  if (trace > 0.0)
+  {
+    double s = 2.0 * sqrt(1.0 + trace);
+    q = Quaternion(0.25 * s, (r21 - r12) / s, (r02 - r20) / s, (r10 - r01) / s);
+  }
+  else if (r00 > r11 && r00 > r22)
+  {
+    double s = 2.0 * sqrt(1.0 + r00 - r11 - r22);
+    q = Quaternion((r21 - r12) / s, 0.25 * s, (r01 + r10) / s, (r02 + r20) / s);
+  }
+  else if (r11 > r22)
+  {
+    double s = 2.0 * sqrt(1.0 + r11 - r00 - r22);
+    q = Quaternion((r02 - r20) / s, (r01 + r10) / s, 0.25 * s, (r12 + r21) / s);
+  }
+  else
+  {
+    double s = 2.0 * sqrt(1.0 + r22 - r00 - r11);
+    q = Quaternion((r10 - r01) / s, (r02 + r20) / s, (r12 + r21) / s, 0.25 * s);
+  }
+  q_ = q;
+  return true;
+}
+
+double HeadingFusion::GetMagneticHeading() const
+{
+  // Body x axis in the earth frame; yaw is counter-clockwise (toward west) from north
+  double north = 1.0 - 2.0 * (q_.y * q_.y + q_.z * q_.z);
+  double west = 2.0 * (q_.x * q_.y + q_.w * q_.z);
+  return Wrap360(-atan2(west, north) * RAD_TO_DEG);
+}
+
+double HeadingFusion::GetTrueHeading() const
+{
+  return Wrap360(GetMagneticHeading() + declination_);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "IMUSensor.h"
+
+/*************************** USER OUTPUT DATA **************************************/
+/* Unit quaternion, rotates body-frame vectors into the earth frame (north, west, up) */
+struct Quaternion
+{
+  double w;
+  double x;
+  double y;
+  double z;
+  Quaternion() : w(1.0), x(0.0), y(0.0), z(0.0) {}
+  Quaternion(const double &qw, const double &qx, const double &qy, const double &qz)
+      : w(qw), x(qx), y(qy), z(qz) {}
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/**
+ * @brief: Madgwick MARG orientation filter (gradient descent on the accelerometer and
+ *         magnetometer errors, gyro integration in between) run once per IMU sample.
+ *         The magnetometer reference is re-derived from the current estimate every
+ *         update, so tilt is compensated and only the horizontal field steers the
+ *         heading. The first sample (or one after a gap) seeds the estimate directly
+ *         from gravity and the field instead of waiting for the filter to converge.
+ *         Body frame: x forward, y left, z up; accel reads +g on z when level, gyro in
+ *         rad/s, magnetometer in any unit. About 0.1 us per update.
+ */
+class HeadingFusion
+{
+public:
+  explicit HeadingFusion(double beta = 0.1, double maxGap = 0.5)
+      : beta_(beta), maxGap_(maxGap), declination_(0.0), seeded_(false) {}
+
+  /* Forget the estimate: the next Update() seeds it again */
+  void Reset() { seeded_ = false; }
+
+  /* Fuse one sample taken dt seconds after the previous one */
+  void Update(const IMUSensorData &sample, double dt);
+
+  /* Magnetic declination [degrees], east positive (WMM D) */
+  void SetDeclination(double declination) { declination_ = declination; }
+
+  bool IsSeeded() const { return seeded_; }
+  const Quaternion &GetQuaternion() const { return q_; }
+
+  /* Heading of the body x axis, clockwise from magnetic / true north [degrees, 0-360) */
+  double GetMagneticHeading() const;
+  double GetTrueHeading() const;
+
+private:
+  bool Seed(const IMUSensorData &sample);
+
+  double beta_;   // Gradient step gain [rad/s]
+  double maxGap_; // Longest dt integrated before re-seeding [s]
+  double declination_;
+  bool seeded_;
+  Quaternion q_;
+};
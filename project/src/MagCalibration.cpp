@@ -0,0 +1,296 @@
+#include "MagCalibration.h"
+#include <math.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+  const double P_INITIAL = 1e4; // Initial covariance diagonal, also the wind-up cap
+
+  /* Eigenvalues and vectors (columns of v) of a symmetric 3x3 by cyclic Jacobi */
+  void Eigen3(double a[3][3], double d[3], double v[3][3])
+  {
+    for (int i = 0; i < 3; i++)
+      for (int j = 0; j < 3; j++)
+        v[i][j] = i == j ? 1.0 : 0.0;
+    for (int sweep = 0; sweep < 32; sweep++)
+    {
+      double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+      if (off < 1e-30)
+        break;
+      for (int p = 0; p < 2; p++)
+        for (int q = p + 1; q < 3; q++)
+        {
+          if (a[p][q] == 0.0)
+            continue;
+          double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+          double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+          double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+          for (int k = 0; k < 3; k++)
+          {
+            double akp = a[k][p], akq = a[k][q];
+            a[k][p] = c * akp - s * akq;
+            a[k][q] = s * akp + c * akq;
+          }
+          for (int k = 0; k < 3; k++)
+          {
+            double apk = a[p][k], aqk = a[q][k];
+            a[p][k] = c * apk - s * aqk;
+            a[q][k] = s * apk + c * aqk;
+          }
+          for (int k = 0; k < 3; k++)
+          {
+            double vkp = v[k][p], vkq = v[k][q];
+            v[k][p] = c * vkp - s * vkq;
+            v[k][q] = s * vkp + c * vkq;
+          }
+        }
+    }
+    for (int i = 0; i < 3; i++)
+      d[i] = a[i][i];
+  }
+} // namespace
+
+void MagCalibration::Reset()
+{
+  scale_ = 0.0;
+  samples_ = 0;
+  for (int i = 0; i < 3; i++)
+    last_[i] = 0.0;
+  for (int i = 0; i < N; i++)
+  {
+    theta_[i] = 0.0;
+    for (int j = 0; j < N; j++)
+      p_[i][j] = i == j ? P_INITIAL : 0.0;
+  }
+  valid_ = false;
+  offset_ = Point3f();
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+      matrix_[i][j] = i == j ? 1.0 : 0.0;
+}
+
+bool MagCalibration::Add(const Point3f &raw)
+{
+  if (scale_ == 0.0)
+  {
+    scale_ = sqrt(raw.X * raw.X + raw.Y * raw.Y + raw.Z * raw.Z);
+    if (scale_ == 0.0)
+      return false;
+  }
+  double x = raw.X / scale_, y = raw.Y / scale_, z = raw.Z / scale_;
+  double dx = x - last_[0], dy = y - last_[1], dz = z - last_[2];
+  if (samples_ > 0 && dx * dx + dy * dy + dz * dz < minStep_ * minStep_)
+    return false;
+  last_[0] = x;
+  last_[1] = y;
+  last_[2] = z;
+  samples_++;
+
+  // RLS: k = P phi / (lambda + phi' P phi), theta += k (1 - phi' theta), P = (P - k phi' P) / lambda
+  const double phi[N] = {x * x, y * y, z * z, 2.0 * x * y, 2.0 * x * z, 2.0 * y * z,
+                         2.0 * x, 2.0 * y, 2.0 * z};
+  double pPhi[N];
+  double denom = forgetting_;
+  double residual = 1.0;
+  for (int i = 0; i < N; i++)
+  {
+    double s = 0.0;
+    for (int j = 0; j < N; j++)
+      s += p_[i][j] * phi[j];
+    pPhi[i] = s;
+    denom += phi[i] * s;
+    residual -= phi[i] * theta_[i];
+  }
+  double trace = 0.0;
+  for (int i = 0; i < N; i++)
+  {
+    double k = pPhi[i] / denom;
+    theta_[i] += k * residual;
+    for (int j = i; j < N; j++)
+      p_[i][j] -= k * pPhi[j]; // P symmetric: P phi phi' P / denom, upper triangle
+    trace += p_[i][i];
+  }
+  // Forget only while the covariance is below its initial size (no wind-up when idle)
+  double scale = trace < N * P_INITIAL ? 1.0 / forgetting_ : 1.0;
+  for (int i = 0; i < N; i++)
+    for (int j = i; j < N; j++)
+    {
+      p_[i][j] *= scale;
+      p_[j][i] = p_[i][j];
+    }
+  return true;
+}
+
+bool MagCalibration::Solve()
+{
+  if (samples_ < minSamples_)
+    return false;
+
+  double a[3][3] = {{theta_[0], theta_[3], theta_[4]},
+                    {theta_[3], theta_[1], theta_[5]},
+                    {theta_[4], theta_[5], theta_[2]}};
+  double d[3], v[3][3];
+  double work[3][3];
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+      work[i][j] = a[i][j];
+  Eigen3(work, d, v);
+  double g[3] = {theta_[6], theta_[7], theta_[8]};
+  double rhs = 1.0;
+  if (d[0] < 0.0 && d[1] < 0.0 && d[2] < 0.0)
+  {
+    // The right-hand side is fixed at 1, so the sign of the fit is arbitrary: with the
+    // origin outside the ellipsoid (offset beyond the field radius) it comes out negative
+    // definite. u'(-A)u + 2(-g)'u = -1 is the same surface.
+    rhs = -1.0;
+    for (int i = 0; i < 3; i++)
+    {
+      d[i] = -d[i];
+      g[i] = -g[i];
+      for (int j = 0; j < 3; j++)
+        a[i][j] = -a[i][j];
+    }
+  }
+  if (d[0] <= 0.0 || d[1] <= 0.0 || d[2] <= 0.0)
+    return false; // Not an ellipsoid: too little of the sphere seen yet
+
+  // Centre o = -A^-1 g, through the eigen decomposition
+  double o[3] = {0.0, 0.0, 0.0};
+  for (int k = 0; k < 3; k++)
+  {
+    double proj = (v[0][k] * g[0] + v[1][k] * g[1] + v[2][k] * g[2]) / d[k];
+    for (int i = 0; i < 3; i++)
+      o[i] -= v[i][k] * proj;
+  }
+  // (u - o)' A (u - o) = rhs + o' A o
+  double r2 = rhs;
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+      r2 += o[i] * a[i][j] * o[j];
+  if (r2 <= 0.0)
+    return false;
+
+  // Soft iron: symmetric sqrt(A / r2), scaled from fit units to the reference radius
+  double gain = reference_ / (scale_ * sqrt(r2));
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+    {
+      double s = 0.0;
+      for (int k = 0; k < 3; k++)
+        s += v[i][k] * sqrt(d[k]) * v[j][k];
+      matrix_[i][j] = s * gain;
+    }
+  offset_ = Point3f(o[0] * scale_, o[1] * scale_, o[2] * scale_);
+  valid_ = true;
+  return true;
+}
+
+Point3f MagCalibration::Apply(const Point3f &raw) const
+{
+  if (!valid_)
+    return raw;
+  double x = raw.X - offset_.X, y = raw.Y - offset_.Y, z = raw.Z - offset_.Z;
+  return Point3f(matrix_[0][0] * x + matrix_[0][1] * y + matrix_[0][2] * z,
+                 matrix_[1][0] * x + matrix_[1][1] * y + matrix_[1][2] * z,
+                 matrix_[2][0] * x + matrix_[2][1] * y + matrix_[2][2] * z);
+}
+
+int MagCalibration::Save(const char *path) const
+{
+  std::ofstream out(path);
+  if (!out)
+    return CAL_NO_FILE;
+  return Save(out);
+}
+
+int MagCalibration::Load(const char *path)
+{
+  std::ifstream in(path);
+  if (!in)
+    return CAL_NO_FILE;
+  return Load(in);
+}
+
+int MagCalibration::Save(std::ostream &out) const
+{
+  out.precision(17);
+  out << "# Magnetometer calibration: calibrated = matrix * (raw - offset)\n";
+  out << "valid " << (valid_ ? 1 : 0) << "\n";
+  out << "offset " << offset_.X << " " << offset_.Y << " " << offset_.Z << "\n";
+  out << "matrix";
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+      out << " " << matrix_[i][j];
+  out << "\n# Fit state\n";
+  out << "scale " << scale_ << "\n";
+  out << "samples " << samples_ << "\n";
+  out << "last " << last_[0] << " " << last_[1] << " " << last_[2] << "\n";
+  out << "theta";
+  for (int i = 0; i < N; i++)
+    out << " " << theta_[i];
+  out << "\ncovariance";
+  for (int i = 0; i < N; i++)
+    for (int j = 0; j < N; j++)
+      out << " " << p_[i][j];
+  out << "\n";
+  return out ? CAL_OK : CAL_NO_FILE;
+}
+
+int MagCalibration::Load(std::istream &in)
+{
+  MagCalibration loaded(forgetting_, minStep_, minSamples_);
+  loaded.reference_ = reference_;
+  int found = 0;
+  bool ok = true;
+  std::string line;
+  while (ok && std::getline(in, line))
+  {
+    std::size_t hash = line.find('#');
+    if (hash != std::string::npos)
+      line.erase(hash);
+    std::istringstream fields(line);
+    std::string key;
+    if (!(fields >> key))
+      continue;
+    if (key == "valid")
+    {
+      int v;
+      ok = static_cast<bool>(fields >> v);
+      loaded.valid_ = v != 0;
+      found |= 1;
+    }
+    else if (key == "offset")
+    {
+      ok = static_cast<bool>(fields >> loaded.offset_.X >> loaded.offset_.Y >> loaded.offset_.Z);
+      found |= 2;
+    }
+    else if (key == "matrix")
+    {
+      for (int i = 0; ok && i < 9; i++)
+        ok = static_cast<bool>(fields >> loaded.matrix_[i / 3][i % 3]);
+      found |= 4;
+    }
+    else if (key == "scale")
+      ok = static_cast<bool>(fields >> loaded.scale_);
+    else if (key == "samples")
+      ok = static_cast<bool>(fields >> loaded.samples_);
+    else if (key == "last")
+      ok = static_cast<bool>(fields >> loaded.last_[0] >> loaded.last_[1] >> loaded.last_[2]);
+    else if (key == "theta")
+    {
+      for (int i = 0; ok && i < N; i++)
+        ok = static_cast<bool>(fields >> loaded.theta_[i]);
+    }
+    else if (key == "covariance")
+    {
+      for (int i = 0; ok && i < N * N; i++)
+        ok = static_cast<bool>(fields >> loaded.p_[i / N][i % N]);
+    }
+  }
+  if (!ok || found != 7)
+    return CAL_BAD_FILE;
+  *this = loaded;
+  return CAL_OK;
+}
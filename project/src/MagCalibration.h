@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <iosfwd>
+#include "Point.h"
+
+/**
+ * @brief: Online hard/soft-iron magnetometer calibration. Samples are fitted to the
+ *         ellipsoid u'Au + 2v'u = 1 by recursive least squares (9 parameters, a 9x9
+ *         covariance; constant memory and time per sample) with exponential forgetting,
+ *         so the fit follows slow changes in the dish structure. Solve() turns the
+ *         ellipsoid into a hard-iron offset and a symmetric soft-iron matrix mapping it
+ *         onto a sphere of the reference radius, the WMM total field F.
+ *         Samples closer than minStep (relative to the field scale) to the last accepted
+ *         one are skipped: a parked dish adds nothing and would wind the covariance up.
+ */
+class MagCalibration
+{
+public:
+  enum CALERROR
+  {
+    CAL_OK = 0,
+    CAL_NO_FILE = -1,  // File could not be opened or written
+    CAL_BAD_FILE = -2, // Missing or unparsable fields
+  };
+
+  explicit MagCalibration(double forgetting = 0.999, double minStep = 0.02,
+                          std::size_t minSamples = 200)
+      : forgetting_(forgetting), minStep_(minStep), minSamples_(minSamples), reference_(1.0)
+  {
+    Reset();
+  }
+
+  /* Drop the fit and the calibration */
+  void Reset();
+
+  /* Radius of the calibrated field, normally WMM F [nT]. Takes effect at the next Solve(). */
+  void SetReference(double radius) { reference_ = radius > 0.0 ? radius : 1.0; }
+
+  /* Feed one raw sample. Returns true if it was accepted into the fit. */
+  bool Add(const Point3f &raw);
+
+  /**
+   * @brief: Derive offset and matrix from the current fit. Returns true and replaces the
+   *         calibration if the fit is an ellipsoid backed by enough samples; otherwise
+   *         the previous calibration stays in force.
+   */
+  bool Solve();
+
+  bool IsValid() const { return valid_; }
+  std::size_t GetSamples() const { return samples_; }
+
+  /* Calibrated field, matrix * (raw - offset); raw itself until the first valid Solve() */
+  Point3f Apply(const Point3f &raw) const;
+
+  const Point3f &GetOffset() const { return offset_; }
+  double GetMatrix(int row, int col) const { return matrix_[row][col]; }
+
+  /* Calibration and fit state as text, so learning continues across restarts */
+  int Save(const char *path) const;
+  int Load(const char *path);
+  int Save(std::ostream &out) const;
+  int Load(std::istream &in);
+
+private:
+  static const int N = 9;
+
+  double forgetting_;
+  double minStep_;
+  std::size_t minSamples_;
+  double reference_;
+
+  double scale_;     // Raw units to the fit's O(1) units, from the first sample
+  double last_[3];   // Last accepted sample [fit units]
+  std::size_t samples_;
+  double theta_[N];  // a b c d e f g h i of ax2+by2+cz2+2dxy+2exz+2fyz+2gx+2hy+2iz = 1
+  double p_[N][N];   // RLS covariance
+
+  bool valid_;
+  Point3f offset_;
+  double matrix_[3][3];
+};
@@ -0,0 +1,236 @@
+#include "MotionPlanner.h"
+#include <algorithm>
+
+namespace
+{
+const double DEG_TO_RAD = 0.017453292519943295;
+const double RATE_WINDOW = 60.0; // Span the sun's angular rate is estimated over [s]
+const double LEAD_SHARE = 0.9;   // Of the deadband the dish is placed ahead of the sun
+const int AIM_ITERATIONS = 3;    // Arrival time and aim point depend on each other
+const double MIN_STEP = 1.0;     // Finest step of the deadband crossing search [s]
+const double CROSS_SHARE = 0.02; // Of the deadband the crossing search stops within
+const int CROSS_ITERATIONS = 64;
+
+/* Great circle approximation, fine for errors of a few degrees */
+double PointingError(double az1, double el1, double az2, double el2)
+{
+  double dAz = remainder(az1 - az2, 360.0) * cos(0.5 * (el1 + el2) * DEG_TO_RAD);
+  double dEl = el1 - el2;
+  return sqrt(dAz * dAz + dEl * dEl);
+}
+
+double Wrap360(double azimuth)
+{
+  azimuth = fmod(azimuth, 360.0);
+  return azimuth < 0.0 ? azimuth + 360.0 : azimuth;
+}
+
+/* Half of the travel spent reaching peak velocity v (acceleration phase) */
+double AccelDistance(double v, const AxisLimits &limits, double *tj, double *ta)
+{
+  const AxisLimits &l = limits;
+  if (v * l.jerk <= l.acceleration * l.acceleration)
+  {
+    // Peak acceleration not reached: two jerk phases only
+    *tj = sqrt(v / l.jerk);
+    *ta = 2.0 * *tj;
+  }
+  else
+  {
+    *tj = l.acceleration / l.jerk;
+    *ta = v / l.acceleration + *tj;
+  }
+  return 0.5 * v * *ta;
+}
+} // namespace
+
+AxisProfile AxisProfile::Plan(double distance, const AxisLimits &limits)
+{
+  AxisProfile p;
+  p.distance = distance;
+  double travel = fabs(distance);
+  if (travel <= 0.0 || limits.velocity <= 0.0 || limits.acceleration <= 0.0 || limits.jerk <= 0.0)
+    return p;
+
+  double v = limits.velocity;
+  if (2.0 * AccelDistance(v, limits, &p.tj, &p.ta) > travel)
+  {
+    // Short move: the highest peak velocity that still fits, by bisection
+    double lo = 0.0, hi = v;
+    for (int i = 0; i < 60; i++)
+    {
+      v = 0.5 * (lo + hi);
+      if (2.0 * AccelDistance(v, limits, &p.tj, &p.ta) > travel)
+        hi = v;
+      else
+        lo = v;
+    }
+    v = lo;
+  }
+  p.tv = (travel - 2.0 * AccelDistance(v, limits, &p.tj, &p.ta)) / v;
+  p.jerk = limits.jerk;
+  p.duration = 2.0 * p.ta + p.tv;
+  return p;
+}
+
+double AxisProfile::Position(double t) const
+{
+  if (duration <= 0.0 || t >= duration)
+    return distance;
+  if (t <= 0.0)
+    return 0.0;
+
+  const double segment[7] = {tj, ta - 2.0 * tj, tj, tv, tj, ta - 2.0 * tj, tj};
+  const double jerks[7] = {jerk, 0.0, -jerk, 0.0, -jerk, 0.0, jerk};
+  double p = 0.0, v = 0.0, a = 0.0;
+  for (int i = 0; i < 7; i++)
+  {
+    double dt = std::min(t, segment[i]);
+    double j = jerks[i];
+    p += v * dt + a * dt * dt / 2.0 + j * dt * dt * dt / 6.0;
+    v += a * dt + j * dt * dt / 2.0;
+    a += j * dt;
+    t -= dt;
+    if (t <= 0.0)
+      break;
+  }
+  return distance < 0.0 ? -p : p;
+}
+
+void MotionPlanner::GetPosition(double time, double *azimuth, double *elevation) const
+{
+  double t = time - startTime_;
+  // The faster axis is stretched in time to arrive with the slower one
+  double azT = duration_ > 0.0 ? t * az_.duration / duration_ : t;
+  double elT = duration_ > 0.0 ? t * el_.duration / duration_ : t;
+  *azimuth = Wrap360(startAz_ + az_.Position(azT));
+  *elevation = startEl_ + el_.Position(elT);
+}
+
+bool MotionPlanner::Update(double time, double azimuth, double elevation, const Predictor &predict,
+                           MoveCommand *move)
+{
+  if (!started_)
+  {
+    // The drive position is unknown until the first move: place it on the target
+    started_ = true;
+    firstTime_ = time;
+    startTime_ = time;
+    startAz_ = azimuth;
+    startEl_ = elevation;
+    az_ = el_ = AxisProfile();
+    duration_ = 0.0;
+    return Plan(time, azimuth, elevation, predict, move);
+  }
+
+  double dishAz, dishEl;
+  GetPosition(time, &dishAz, &dishEl);
+  double error = PointingError(dishAz, dishEl, azimuth, elevation);
+  stats_.elapsed = time - firstTime_;
+  stats_.sumSquares += error * error;
+  stats_.samples++;
+  stats_.maxError = std::max(stats_.maxError, error);
+
+  // A move in flight already leads the sun: later corrections wait for the next one
+  if (time < startTime_ + duration_)
+    return false;
+
+  if (error <= config_.deadband)
+  {
+    double az, el;
+    if (!predict(time + config_.lookahead, &az, &el) ||
+        PointingError(dishAz, dishEl, az, el) <= config_.deadband)
+      return false;
+  }
+  return Plan(time, azimuth, elevation, predict, move);
+}
+
+double MotionPlanner::GetNextUpdate(double time, const Predictor &predict, double maxInterval) const
+{
+  double end = startTime_ + duration_;
+  if (time < end)
+    return std::min(end, time + maxInterval);
+
+  // March along the predicted track. The error can grow no faster than the target
+  // moves, so a step of (deadband - error) / rate does not jump over the crossing.
+  double dishAz, dishEl;
+  GetPosition(time, &dishAz, &dishEl);
+  double limit = time + maxInterval;
+  double t = time;
+  for (int i = 0; i < CROSS_ITERATIONS && t < limit; i++)
+  {
+    double az, el, nextAz, nextEl;
+    if (!predict(t, &az, &el) || !predict(t + RATE_WINDOW, &nextAz, &nextEl))
+      return time;
+    double margin = config_.deadband - PointingError(dishAz, dishEl, az, el);
+    if (margin <= CROSS_SHARE * config_.deadband)
+      break;
+    double rate = PointingError(az, el, nextAz, nextEl) / RATE_WINDOW;
+    t += rate > 0.0 ? std::max(MIN_STEP, margin / rate) : maxInterval;
+  }
+  return std::max(time, std::min(t, limit) - config_.lookahead);
+}
+
+void MotionPlanner::MoveTo(double time, double azimuth, double elevation, MoveCommand *move)
+{
+  double fromAz = azimuth, fromEl = elevation;
+  if (started_)
+    GetPosition(time, &fromAz, &fromEl);
+  else
+  {
+    started_ = true;
+    firstTime_ = time;
+  }
+  startTime_ = time;
+  startAz_ = fromAz;
+  startEl_ = fromEl;
+  az_ = el_ = AxisProfile();
+  duration_ = 0.0;
+  Plan(time, azimuth, elevation, [](double, double *, double *) { return false; }, move);
+}
+
+bool MotionPlanner::Plan(double time, double azimuth, double elevation, const Predictor &predict,
+                         MoveCommand *move)
+{
+  double fromAz = startAz_ + az_.distance;
+  double fromEl = startEl_ + el_.distance;
+
+  // Lead the sun so the error sweeps from +LEAD_SHARE deadband through zero to -deadband
+  double lead = config_.maxLead;
+  double az, el;
+  if (predict(time + RATE_WINDOW, &az, &el))
+  {
+    double rate = PointingError(az, el, azimuth, elevation) / RATE_WINDOW;
+    if (rate > 0.0)
+      lead = std::min(lead, LEAD_SHARE * config_.deadband / rate);
+  }
+
+  double duration = 0.0;
+  double aimAz = azimuth, aimEl = elevation;
+  for (int i = 0; i < AIM_ITERATIONS; i++)
+  {
+    if (predict(time + duration + lead, &az, &el))
+    {
+      aimAz = az;
+      aimEl = el;
+    }
+    az_ = AxisProfile::Plan(remainder(aimAz - fromAz, 360.0), config_.azimuth);
+    el_ = AxisProfile::Plan(aimEl - fromEl, config_.elevation);
+    duration = std::max(az_.duration, el_.duration);
+  }
+
+  startTime_ = time;
+  startAz_ = fromAz;
+  startEl_ = fromEl;
+  duration_ = duration;
+  stats_.commands++;
+  stats_.moving += duration;
+
+  move->startTime = time;
+  move->duration = duration;
+  move->azimuth = Wrap360(startAz_ + az_.distance);
+  move->elevation = startEl_ + el_.distance;
+  move->azimuthTravel = az_.distance;
+  move->elevationTravel = el_.distance;
+  return true;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <math.h>
+#include <cstddef>
+#include <functional>
+#include "IActuator.h"
+
+/*************************** USER INPUT DATA ***************************************/
+struct AxisLimits
+{
+  double velocity;     // [degrees/s]
+  double acceleration; // [degrees/s^2]
+  double jerk;         // [degrees/s^3]
+  AxisLimits(const double &v = 1.0, const double &a = 0.5, const double &j = 1.0)
+      : velocity(v), acceleration(a), jerk(j) {}
+};
+
+struct PlannerConfig
+{
+  double deadband;  // Pointing error allowed before the dish is moved [degrees]
+  double lookahead; // Horizon the error is predicted over, at least one tick [s]
+  double maxLead;   // Longest the dish may be placed ahead of the sun [s]
+  AxisLimits azimuth;
+  AxisLimits elevation;
+  PlannerConfig(const double &d = 0.1, const double &l = 2.0, const double &m = 600.0,
+                const AxisLimits &az = AxisLimits(), const AxisLimits &el = AxisLimits())
+      : deadband(d), lookahead(l), maxLead(m), azimuth(az), elevation(el) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+struct PlannerStats
+{
+  std::size_t commands; // Moves issued
+  std::size_t samples;  // Updates with a pointing error sample
+  double elapsed;       // Time from the first update to the last [s]
+  double sumSquares;    // Of the pointing error [degrees^2]
+  double maxError;      // [degrees]
+  double moving;        // Time spent moving [s]
+  PlannerStats() : commands(0), samples(0), elapsed(0.0), sumSquares(0.0), maxError(0.0), moving(0.0) {}
+
+  double GetCommandsPerHour() const { return elapsed > 0.0 ? commands * 3600.0 / elapsed : 0.0; }
+  double GetRmsError() const { return samples ? sqrt(sumSquares / samples) : 0.0; }
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/* Jerk-limited (7 segment S-curve) rest-to-rest move of one axis */
+struct AxisProfile
+{
+  double distance; // Signed travel [degrees]
+  double duration; // [s]
+  double tj;       // Jerk phase
+  double ta;       // Acceleration phase, both jerk phases included
+  double tv;       // Cruise phase
+  double jerk;     // Peak jerk [degrees/s^3]
+  AxisProfile() : distance(0.0), duration(0.0), tj(0.0), ta(0.0), tv(0.0), jerk(0.0) {}
+
+  /* Fastest profile for the travel within the limits */
+  static AxisProfile Plan(double distance, const AxisLimits &limits);
+  /* Travel done at t [0, duration] */
+  double Position(double t) const;
+};
+
+/**
+ * @brief: Sits between the sun position and the actuator. The dish is held still while
+ *         the predicted pointing error stays inside the deadband; once it would leave it
+ *         within the look-ahead horizon a single move is planned for both axes (one bus
+ *         command), aimed where the sun will be a little after arrival so the error sweeps
+ *         the whole band before the next move. Moves are S-curve profiles per axis,
+ *         stretched so both axes arrive together. Corrections that come up while a move
+ *         is in flight are coalesced into the next one. The dish is assumed to follow the
+ *         profiles (there is no encoder feedback); its modelled position is what the
+ *         error statistics measure.
+ */
+class MotionPlanner
+{
+public:
+  /* Target at an absolute time [s]: azimuth (base frame) and elevation. False if unknown. */
+  typedef std::function<bool(double time, double *azimuth, double *elevation)> Predictor;
+
+  explicit MotionPlanner(const PlannerConfig &config) : config_(config), started_(false), firstTime_(0.0) {}
+
+  const PlannerConfig &GetConfig() const { return config_; }
+
+  /**
+   * @brief: One tick at time with the current target. Returns true and fills *move when
+   *         a move should be sent now.
+   */
+  bool Update(double time, double azimuth, double elevation, const Predictor &predict, MoveCommand *move);
+
+  /**
+   * @brief: Latest time the next Update() may come without the error leaving the
+   *         deadband: the end of a move in flight, else one look-ahead before the
+   *         predicted target leaves the band around the resting dish. Capped at time +
+   *         maxInterval. For callers that sleep between updates instead of ticking.
+   */
+  double GetNextUpdate(double time, const Predictor &predict, double maxInterval) const;
+
+  /* One move from the modelled position straight to a fixed target (a stow position),
+     without the lead; tracking resumes with Update() from where it ends */
+  void MoveTo(double time, double azimuth, double elevation, MoveCommand *move);
+
+  /* Modelled dish position at time */
+  void GetPosition(double time, double *azimuth, double *elevation) const;
+
+  const PlannerStats &GetStats() const { return stats_; }
+
+private:
+  bool Plan(double time, double azimuth, double elevation, const Predictor &predict, MoveCommand *move);
+
+  PlannerConfig config_;
+  bool started_;
+  double firstTime_;
+  PlannerStats stats_;
+
+  // Current move; at rest on its end point once time passes start + duration
+  double startTime_;
+  double startAz_; // Unwrapped
+  double startEl_;
+  AxisProfile az_;
+  AxisProfile el_;
+  double duration_;
+};
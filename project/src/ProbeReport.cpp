@@ -0,0 +1,85 @@
+#include "ProbeReport.h"
+#include <algorithm>
+#include <iomanip>
+#include "Probe.h"
+
+#ifdef PST_PROBES
+namespace
+{
+  const char *const PROBE_NAMES[PROBE_STAGES] = {"declinition", "wmm", "spa", "imu-read", "gps-read",
+                                                "weather", "sensors", "heading", "sun", "command", "tick"};
+  const char *const COUNTER_NAMES[COUNTER_COUNT] = {"wmm-memo", "imu-samples", "moves", "missed"};
+
+  /* Value [ticks] at quantile q of a merged histogram: the top of the bucket holding that
+     rank, or the exact max if lower */
+  double Quantile(const std::vector<uint64_t> &buckets, uint64_t count, uint64_t max, double q)
+  {
+    uint64_t rank = static_cast<uint64_t>(q * count);
+    if (rank >= count)
+      rank = count - 1;
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); i++)
+    {
+      seen += buckets[i];
+      if (seen > rank)
+        return static_cast<double>(std::min(ProbeBucketValue(i), max));
+    }
+    return 0.0;
+  }
+} // namespace
+#endif
+
+void DumpProbes(std::ostream &out)
+{
+#ifndef PST_PROBES
+  out << "Probes are compiled out: configure with -DPROBES=ON" << std::endl;
+#else
+  ProbeRegistry &registry = GetProbeRegistry();
+  std::vector<ProbeThread *> threads;
+  {
+    std::lock_guard<std::mutex> hold(registry.lock);
+    threads = registry.threads;
+  }
+
+  const double us = registry.GetTicksPerNs() * 1e3; // Ticks per microsecond
+  out << "Probes (" << threads.size() << " threads), times in us:" << std::endl;
+  out << "  " << std::left << std::setw(12) << "stage" << std::right << std::setw(12) << "count"
+      << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10)
+      << "p99.9" << std::setw(10) << "max" << std::endl;
+  std::vector<uint64_t> buckets(PROBE_BUCKETS);
+  for (int p = 0; p < PROBE_STAGES; p++)
+  {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    uint64_t count = 0, total = 0, max = 0;
+    for (ProbeThread *t : threads)
+    {
+      for (std::size_t i = 0; i < PROBE_BUCKETS; i++)
+      {
+        uint64_t n = t->buckets[p][i].load(std::memory_order_relaxed);
+        buckets[i] += n;
+        count += n;
+      }
+      total += t->total[p].load(std::memory_order_relaxed);
+      max = std::max(max, t->max[p].load(std::memory_order_relaxed));
+    }
+    if (count == 0)
+      continue;
+    out << "  " << std::left << std::setw(12) << PROBE_NAMES[p] << std::right << std::setw(12) << count
+        << std::fixed << std::setprecision(2) << std::setw(10) << total / us / count << std::setw(10)
+        << Quantile(buckets, count, max, 0.5) / us << std::setw(10) << Quantile(buckets, count, max, 0.99) / us
+        << std::setw(10) << Quantile(buckets, count, max, 0.999) / us << std::setw(10) << max / us << std::endl;
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+  }
+
+  out << "Counters:";
+  for (int c = 0; c < COUNTER_COUNT; c++)
+  {
+    uint64_t n = 0;
+    for (ProbeThread *t : threads)
+      n += t->counters[c].load(std::memory_order_relaxed);
+    out << " " << COUNTER_NAMES[c] << " " << n;
+  }
+  out << std::endl;
+#endif
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <ostream>
+
+/**
+ * @brief: Merge every thread's probe histograms and counters (Probe.h) and print count,
+ *         mean, p50, p99, p99.9 and max per probe. Safe while the probes keep running:
+ *         the figures are a snapshot, each counter read once.
+ */
+void DumpProbes(std::ostream &out);
@@ -0,0 +1,182 @@
+#include "SensorLog.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+  const char LOG_MAGIC[8] = "PSTLOG1";
+  const std::size_t WRITE_BUFFER = 1 << 20;
+  const std::size_t MAX_PAYLOAD = 0xFFF8;
+
+  std::size_t Padded(std::size_t size)
+  {
+    return (size + 7) & ~static_cast<std::size_t>(7);
+  }
+} // namespace
+
+LogClock ToLogClock(const ClockTime &now)
+{
+  LogClock c;
+  c.year = now.local.dt.year;
+  c.month = now.local.dt.month;
+  c.date = now.local.dt.date;
+  c.hour = now.local.tt.hour;
+  c.minute = now.local.tt.minute;
+  c.second = now.local.tt.second;
+  c.timezone = now.local.tt.timezone;
+  c.fraction = now.fraction;
+  c.unixTime = now.unixTime;
+  c.jdUtc = now.jdUtc;
+  c.decimalYear = now.decimalYear;
+  return c;
+}
+
+ClockTime FromLogClock(const LogClock &c)
+{
+  ClockTime now;
+  now.local = DateTimeData(c.year, c.month, c.date, c.hour, c.minute, c.second, c.timezone);
+  now.fraction = c.fraction;
+  now.unixTime = c.unixTime;
+  now.jdUtc = c.jdUtc;
+  now.decimalYear = c.decimalYear;
+  return now;
+}
+
+int SensorRecorder::Open(const char *path)
+{
+  Close();
+  file_ = fopen(path, "ab");
+  if (file_ == nullptr)
+    return errCode_ = LOG_NO_FILE;
+  setvbuf(file_, nullptr, _IOFBF, WRITE_BUFFER);
+  errCode_ = LOG_OK;
+  return LOG_OK;
+}
+
+int SensorRecorder::Close()
+{
+  if (file_ == nullptr)
+    return errCode_;
+  if (fclose(file_) != 0 && errCode_ == LOG_OK)
+    errCode_ = LOG_NO_FILE;
+  file_ = nullptr;
+  return errCode_;
+}
+
+void SensorRecorder::BeginSession(double fusionGain, const char *calibration)
+{
+  tick_ = 0;
+  LogSession session;
+  memcpy(session.magic, LOG_MAGIC, sizeof(session.magic));
+  session.fusionGain = fusionGain;
+  Write(LOG_SESSION, &session, sizeof(session));
+  Write(LOG_CALIBRATION, calibration, strlen(calibration) + 1);
+}
+
+void SensorRecorder::Record(const ClockTime &now)
+{
+  LogClock c = ToLogClock(now);
+  Write(LOG_CLOCK, &c, sizeof(c));
+}
+
+void SensorRecorder::RecordCommand(double azimuth, double elevation, int errCode)
+{
+  LogCommand c;
+  c.azimuth = azimuth;
+  c.elevation = elevation;
+  c.errCode = errCode;
+  c.reserved = 0;
+  Write(LOG_COMMAND, &c, sizeof(c));
+}
+
+void SensorRecorder::Write(int type, const void *payload, std::size_t size)
+{
+  if (file_ == nullptr || errCode_ != LOG_OK)
+    return;
+  std::size_t padded = Padded(size);
+  if (padded > MAX_PAYLOAD)
+  {
+    errCode_ = LOG_BAD_FILE;
+    return;
+  }
+  LogRecordHeader header;
+  header.type = static_cast<uint16_t>(type);
+  header.size = static_cast<uint16_t>(padded);
+  header.tick = tick_;
+  static const unsigned char zeros[8] = {0};
+  if (fwrite(&header, sizeof(header), 1, file_) != 1 ||
+      (size > 0 && fwrite(payload, size, 1, file_) != 1) ||
+      (padded > size && fwrite(zeros, padded - size, 1, file_) != 1))
+    errCode_ = LOG_NO_FILE;
+}
+
+int SensorLogReader::Open(const char *path)
+{
+  Close();
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return LOG_NO_FILE;
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return LOG_NO_FILE;
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ > 0)
+  {
+    void *map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+      close(fd);
+      size_ = 0;
+      return LOG_NO_FILE;
+    }
+    madvise(map, size_, MADV_SEQUENTIAL);
+    base_ = static_cast<const unsigned char *>(map);
+  }
+  close(fd);
+  offset_ = 0;
+
+  // A log starts with a session
+  const LogRecordHeader *header;
+  if (!Peek(&header) || header->type != LOG_SESSION || header->size < sizeof(LogSession) ||
+      memcmp(base_ + sizeof(LogRecordHeader), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0)
+  {
+    Close();
+    return LOG_BAD_FILE;
+  }
+  return LOG_OK;
+}
+
+void SensorLogReader::Close()
+{
+  if (base_ != nullptr)
+    munmap(const_cast<unsigned char *>(base_), size_);
+  base_ = nullptr;
+  size_ = 0;
+  offset_ = 0;
+}
+
+bool SensorLogReader::Peek(const LogRecordHeader **header) const
+{
+  if (size_ - offset_ < sizeof(LogRecordHeader))
+    return false;
+  const LogRecordHeader *h = reinterpret_cast<const LogRecordHeader *>(base_ + offset_);
+  if (size_ - offset_ - sizeof(LogRecordHeader) < h->size)
+    return false;
+  *header = h;
+  return true;
+}
+
+bool SensorLogReader::Next(const LogRecordHeader **header, const void **payload)
+{
+  if (!Peek(header))
+    return false;
+  *payload = base_ + offset_ + sizeof(LogRecordHeader);
+  offset_ += sizeof(LogRecordHeader) + (*header)->size;
+  return true;
+}
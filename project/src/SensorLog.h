@@ -0,0 +1,134 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <cstddef>
+#include "HighResClock.h"
+#include "IGPSSensor.h"
+#include "IMUSensor.h"
+#include "IWeather.h"
+#include "MotionPlanner.h"
+#include "SensorSample.h"
+
+/*************************** LOG FORMAT ********************************************/
+/* Every record: this header, then size bytes of payload, padded to 8 bytes. Native
+   byte order; a log is read back on the machine (or architecture) that wrote it. */
+struct LogRecordHeader
+{
+  uint16_t type; // LOGRECORD
+  uint16_t size; // Payload bytes, a multiple of 8
+  uint32_t tick; // Control tick the record belongs to, from 1 in each session
+};
+
+enum LOGRECORD
+{
+  LOG_SESSION = 1, // LogSession: starts a run, every later record belongs to it
+  LOG_CALIBRATION, // MagCalibration::Save() text, NUL terminated
+  LOG_CLOCK,       // LogClock
+  LOG_IMU,         // Timestamped<IMUSensorData>
+  LOG_GPS,         // Timestamped<Position>
+  LOG_WEATHER,     // Timestamped<WeatherData>
+  LOG_COMMAND,     // LogCommand
+  LOG_PLANNER,     // PlannerConfig: the run sends planned moves, see MotionPlanner
+};
+
+struct LogSession
+{
+  char magic[8];     // "PSTLOG1"
+  double fusionGain; // HeadingFusion beta of the run
+};
+
+struct LogClock
+{
+  int32_t year, month, date, hour, minute, second;
+  double timezone;
+  double fraction, unixTime, jdUtc, decimalYear;
+};
+
+struct LogCommand
+{
+  double azimuth;
+  double elevation;
+  int32_t errCode; // IActuator::SendCommand() / SendMove() result
+  int32_t reserved;
+};
+/*************************** END LOG FORMAT ****************************************/
+
+enum LOGERROR
+{
+  LOG_OK = 0,
+  LOG_NO_FILE = -1,  // File could not be opened, mapped or written
+  LOG_BAD_FILE = -2, // Not a sensor log, or a truncated record
+};
+
+/**
+ * @brief: Append-only binary recorder of a tracking run: every sensor sample the loop
+ *         consumed and every command it produced, tagged with the tick. Writes go
+ *         through a large stdio buffer; nothing is flushed mid-run except by the buffer
+ *         filling, and the file is only ever appended to (a log may hold many sessions).
+ */
+class SensorRecorder
+{
+public:
+  SensorRecorder() : file_(nullptr), tick_(0), errCode_(LOG_OK) {}
+  ~SensorRecorder() { Close(); }
+
+  SensorRecorder(const SensorRecorder &) = delete;
+  SensorRecorder &operator=(const SensorRecorder &) = delete;
+
+  int Open(const char *path);
+  int Close();
+
+  /* Start a session: header and the calibration text the run starts from. A planner
+     configuration, if any, is recorded right after. */
+  void BeginSession(double fusionGain, const char *calibration);
+  void BeginTick() { tick_++; }
+
+  void Record(const ClockTime &now);
+  void Record(const Timestamped<IMUSensorData> &sample) { Write(LOG_IMU, &sample, sizeof(sample)); }
+  void Record(const Timestamped<Position> &fix) { Write(LOG_GPS, &fix, sizeof(fix)); }
+  void Record(const Timestamped<WeatherData> &reading) { Write(LOG_WEATHER, &reading, sizeof(reading)); }
+  void Record(const PlannerConfig &config) { Write(LOG_PLANNER, &config, sizeof(config)); }
+  void RecordCommand(double azimuth, double elevation, int errCode);
+
+  /* LOG_OK, or the first write error */
+  int GetErrCode() const { return errCode_; }
+
+private:
+  void Write(int type, const void *payload, std::size_t size);
+
+  FILE *file_;
+  uint32_t tick_;
+  int errCode_;
+};
+
+/**
+ * @brief: Read-only view of a sensor log through mmap: records are walked in place,
+ *         without a read() or a copy per record.
+ */
+class SensorLogReader
+{
+public:
+  SensorLogReader() : base_(nullptr), size_(0), offset_(0) {}
+  ~SensorLogReader() { Close(); }
+
+  SensorLogReader(const SensorLogReader &) = delete;
+  SensorLogReader &operator=(const SensorLogReader &) = delete;
+
+  int Open(const char *path);
+  void Close();
+
+  /* Next record, or false at the end. Check Truncated() after the last one. */
+  bool Next(const LogRecordHeader **header, const void **payload);
+  /* Look at the next record without consuming it */
+  bool Peek(const LogRecordHeader **header) const;
+  bool Truncated() const { return offset_ != size_; }
+
+private:
+  const unsigned char *base_;
+  std::size_t size_;
+  std::size_t offset_;
+};
+
+/* LogClock <-> ClockTime */
+LogClock ToLogClock(const ClockTime &now);
+ClockTime FromLogClock(const LogClock &clock);
@@ -0,0 +1,175 @@
+#include "SensorReplay.h"
+#include <string.h>
+#include <memory>
+#include <sstream>
+#include "SensorLog.h"
+#include "TrackingCore.h"
+
+namespace
+{
+  typedef TrackingCore<IMUSensor, IGPSSensor, IWeather, ReplayClock, IActuator> ReplayCore;
+
+  struct Frame
+  {
+    uint32_t tick;
+    bool hasClock;
+    bool hasCommand;
+    LogCommand command;
+  };
+
+  /* Load the records of the next tick into the replay sources. Stops at a session. */
+  bool ReadFrame(SensorLogReader &log, ReplayIMU &imu, ReplayGPS &gps, ReplayWeather &weather,
+                 ReplayClock &clock, ReplayActuator &actuator, Frame *frame)
+  {
+    const LogRecordHeader *header;
+    if (!log.Peek(&header) || header->type == LOG_SESSION)
+      return false;
+
+    imu.samples.clear();
+    gps.fixes.clear();
+    weather.readings.clear();
+    frame->tick = header->tick;
+    frame->hasClock = false;
+    frame->hasCommand = false;
+    actuator.errCode = 0;
+
+    const void *payload;
+    while (log.Peek(&header) && header->type != LOG_SESSION && header->tick == frame->tick)
+    {
+      log.Next(&header, &payload);
+      switch (header->type)
+      {
+      case LOG_IMU:
+      {
+        Timestamped<IMUSensorData> s;
+        memcpy(&s, payload, sizeof(s));
+        imu.samples.push_back(s);
+        break;
+      }
+      case LOG_GPS:
+      {
+        Timestamped<Position> f;
+        memcpy(&f, payload, sizeof(f));
+        gps.fixes.push_back(f);
+        break;
+      }
+      case LOG_WEATHER:
+      {
+        Timestamped<WeatherData> w;
+        memcpy(&w, payload, sizeof(w));
+        weather.readings.push_back(w);
+        break;
+      }
+      case LOG_CLOCK:
+      {
+        LogClock c;
+        memcpy(&c, payload, sizeof(c));
+        clock.now = FromLogClock(c);
+        frame->hasClock = true;
+        break;
+      }
+      case LOG_COMMAND:
+        memcpy(&frame->command, payload, sizeof(frame->command));
+        actuator.errCode = frame->command.errCode;
+        frame->hasCommand = true;
+        break;
+      default:
+        break; // Unknown record from a newer writer: skip
+      }
+    }
+    return true;
+  }
+} // namespace
+
+ReplayResult ReplayLog(const char *path, WMMEngine &wmm)
+{
+  ReplayResult result;
+  SensorLogReader log;
+  result.errCode = log.Open(path);
+  if (result.errCode != LOG_OK)
+    return result;
+
+  ReplayIMU imu;
+  ReplayGPS gps;
+  ReplayWeather weather;
+  ReplayClock clock;
+  ReplayActuator actuator;
+  double start = MonotonicNow();
+  double firstTime = 0.0, lastTime = 0.0;
+
+  const LogRecordHeader *header;
+  const void *payload;
+  while (log.Next(&header, &payload))
+  {
+    if (header->type != LOG_SESSION)
+    {
+      // Every tick is logged inside a session, error ticks included
+      result.errCode = LOG_BAD_FILE;
+      break;
+    }
+    LogSession session;
+    memcpy(&session, payload, sizeof(session));
+    result.sessions++;
+
+    ReplayCore core(imu, gps, weather, clock, actuator, wmm, session.fusionGain);
+    if (log.Peek(&header) && header->type == LOG_CALIBRATION)
+    {
+      log.Next(&header, &payload);
+      const char *calibration = static_cast<const char *>(payload);
+      std::istringstream text(std::string(calibration, strnlen(calibration, header->size)));
+      if (core.GetMagCalibration().Load(text) != MagCalibration::CAL_OK)
+      {
+        result.errCode = LOG_BAD_FILE;
+        break;
+      }
+      core.MarkCalibrationSolved();
+    }
+    std::unique_ptr<MotionPlanner> planner;
+    if (log.Peek(&header) && header->type == LOG_PLANNER)
+    {
+      log.Next(&header, &payload);
+      PlannerConfig config;
+      memcpy(&config, payload, sizeof(config));
+      planner.reset(new MotionPlanner(config));
+      core.SetPlanner(planner.get());
+    }
+
+    // Step through failed ticks like TrackingDaemon::Run(): the recording went on after them
+    Frame frame;
+    while (ReadFrame(log, imu, gps, weather, clock, actuator, &frame))
+    {
+      if (!frame.hasClock)
+      {
+        result.errCode = LOG_BAD_FILE;
+        break;
+      }
+      if (result.ticks == 0)
+        firstTime = clock.now.unixTime;
+      lastTime = clock.now.unixTime;
+
+      actuator.sent = false;
+      int errCode = core.Step();
+      result.ticks++;
+      if (errCode != 0 && errCode != ReplayCore::NOTREADY)
+        result.errors++;
+      if (frame.hasCommand || actuator.sent)
+      {
+        result.commands++;
+        if (frame.hasCommand != actuator.sent ||
+            memcmp(&frame.command.azimuth, &actuator.azimuth, sizeof(double)) != 0 ||
+            memcmp(&frame.command.elevation, &actuator.elevation, sizeof(double)) != 0)
+        {
+          if (result.mismatches++ == 0)
+            result.firstMismatch = frame.tick;
+        }
+      }
+    }
+    if (result.errCode != 0)
+      break;
+  }
+  result.truncated = log.Truncated();
+
+  result.logSeconds = lastTime - firstTime;
+  result.wallSeconds = MonotonicNow() - start;
+  return result;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "HighResClock.h"
+#include "IActuator.h"
+#include "IGPSSensor.h"
+#include "IMUSensor.h"
+#include "IWeather.h"
+#include "WMMLib.h"
+
+/*************************** USER OUTPUT DATA **************************************/
+struct ReplayResult
+{
+  int errCode;               // LOGERROR of the log
+  std::size_t sessions;      // Runs found in the log
+  std::size_t ticks;         // Ticks replayed
+  std::size_t errors;        // Of those, ticks the core failed (replayed on like the daemon does)
+  std::size_t commands;      // Commands compared
+  std::size_t mismatches;    // Ticks whose command differs from the recorded bits
+  std::size_t firstMismatch; // Session tick of the first mismatch, 0 for none
+  double logSeconds;         // Recorded time covered [s]
+  double wallSeconds;        // Time the replay took [s]
+  bool truncated;            // The log ends in a partial record (writer killed mid-run)
+  ReplayResult()
+      : errCode(0), sessions(0), ticks(0), errors(0), commands(0), mismatches(0), firstMismatch(0),
+        logSeconds(0.0), wallSeconds(0.0), truncated(false) {}
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/* Recorded inputs of one tick, served through the sensor interfaces */
+class ReplayIMU : public IMUSensor
+{
+public:
+  virtual SampleSpan<const Timestamped<IMUSensorData>> GetIMUSamples() override
+  {
+    return SampleSpan<const Timestamped<IMUSensorData>>(samples.data(), samples.size());
+  }
+  std::vector<Timestamped<IMUSensorData>> samples;
+};
+
+class ReplayGPS : public IGPSSensor
+{
+public:
+  virtual SampleSpan<const Timestamped<Position>> GetPositionSamples() override
+  {
+    return SampleSpan<const Timestamped<Position>>(fixes.data(), fixes.size());
+  }
+  std::vector<Timestamped<Position>> fixes;
+};
+
+class ReplayWeather : public IWeather
+{
+public:
+  virtual SampleSpan<const Timestamped<WeatherData>> GetWeatherSamples() override
+  {
+    return SampleSpan<const Timestamped<WeatherData>>(readings.data(), readings.size());
+  }
+  std::vector<Timestamped<WeatherData>> readings;
+};
+
+class ReplayClock
+{
+public:
+  ClockTime Now() const { return now; }
+  ClockTime now;
+};
+
+/* Captures the replayed command and answers with the recorded actuator result */
+class ReplayActuator : public IActuator
+{
+public:
+  ReplayActuator() : sent(false), azimuth(0.0), elevation(0.0), errCode(0) {}
+  virtual int SendCommand(const double &az, const double &el) override
+  {
+    sent = true;
+    azimuth = az;
+    elevation = el;
+    return errCode;
+  }
+  bool sent;
+  double azimuth;
+  double elevation;
+  int errCode;
+};
+
+/**
+ * @brief: Rerun a SensorRecorder log through TrackingCore as fast as the CPU allows: each
+ *         recorded tick's samples, fixes, weather and clock are fed back through the
+ *         sensor interfaces, and the command the core produces is compared bit for bit
+ *         with the recorded one. Every session starts from a fresh core with the
+ *         recorded fusion gain and calibration. A tick the core fails is counted and the
+ *         replay goes on, as the daemon did when it recorded the session.
+ */
+ReplayResult ReplayLog(const char *path, WMMEngine &wmm);
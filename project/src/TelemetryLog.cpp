@@ -0,0 +1,134 @@
+#include "TelemetryLog.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iomanip>
+
+namespace
+{
+  const char TELEMETRY_MAGIC[8] = "PSTTLM1";
+
+  bool IsValidHeader(const TelemetryHeader &h, std::size_t fileSize)
+  {
+    return memcmp(h.magic, TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC)) == 0 &&
+           h.recordSize == sizeof(TelemetryRecord) && h.capacity > 0 &&
+           fileSize >= TelemetryLog::DATA_OFFSET + h.capacity * sizeof(TelemetryRecord);
+  }
+} // namespace
+
+int TelemetryLog::Open(const char *path, std::size_t capacity)
+{
+  Close();
+  if (capacity == 0)
+    return errCode_ = TELEMETRY_BAD_FILE;
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    return errCode_ = TELEMETRY_NO_FILE;
+
+  // Keep a log of the same geometry, start over otherwise
+  std::size_t size = DATA_OFFSET + capacity * sizeof(TelemetryRecord);
+  TelemetryHeader existing;
+  struct stat st;
+  bool keep = fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) == size &&
+              pread(fd, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing)) &&
+              IsValidHeader(existing, size) && existing.capacity == capacity;
+  if (!keep && (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0))
+  {
+    close(fd);
+    return errCode_ = TELEMETRY_NO_FILE;
+  }
+
+  void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return errCode_ = TELEMETRY_NO_FILE;
+  size_ = size;
+  header_ = static_cast<TelemetryHeader *>(map);
+  records_ = reinterpret_cast<TelemetryRecord *>(static_cast<char *>(map) + DATA_OFFSET);
+  if (!keep)
+  {
+    // The file reads back as zeros: only the header needs writing
+    memcpy(header_->magic, TELEMETRY_MAGIC, sizeof(header_->magic));
+    header_->recordSize = sizeof(TelemetryRecord);
+    header_->reserved = 0;
+    header_->capacity = capacity;
+    header_->head = 0;
+  }
+  return errCode_ = TELEMETRY_OK;
+}
+
+void TelemetryLog::Close()
+{
+  if (header_ != nullptr)
+    munmap(header_, size_); // Dirty pages stay in the page cache and are written back
+  header_ = nullptr;
+  records_ = nullptr;
+  size_ = 0;
+}
+
+int DecodeTelemetry(const char *path, std::ostream &out, std::size_t *records)
+{
+  if (records != nullptr)
+    *records = 0;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return TELEMETRY_NO_FILE;
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return TELEMETRY_NO_FILE;
+  }
+  std::size_t size = static_cast<std::size_t>(st.st_size);
+  if (size < TelemetryLog::DATA_OFFSET)
+  {
+    close(fd);
+    return TELEMETRY_BAD_FILE;
+  }
+  void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return TELEMETRY_NO_FILE;
+  const TelemetryHeader &header = *static_cast<const TelemetryHeader *>(map);
+  if (!IsValidHeader(header, size))
+  {
+    munmap(map, size);
+    return TELEMETRY_BAD_FILE;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+  const TelemetryRecord *slots =
+      reinterpret_cast<const TelemetryRecord *>(static_cast<const char *>(map) + TelemetryLog::DATA_OFFSET);
+
+  out << "sequence,time,tracker,error,flags,latitude,longitude,altitude,speed,imu_samples,"
+         "accel_x,accel_y,accel_z,gyro_x,gyro_y,gyro_z,mag_x,mag_y,mag_z,temperature,pressure,"
+         "humidity,declination,heading,sun_azimuth,sun_elevation,command_azimuth,command_elevation\n";
+  out << std::setprecision(9);
+  // Oldest record still in the ring to the newest; a slot holding another number was
+  // overwritten by a later lap or cut mid-write
+  std::size_t rows = 0;
+  uint64_t first = header.head > header.capacity ? header.head - header.capacity + 1 : 1;
+  for (uint64_t n = first; n <= header.head; n++)
+  {
+    const TelemetryRecord &r = slots[(n - 1) % header.capacity];
+    if (r.sequence != n)
+      continue;
+    out << r.sequence << ',' << std::setprecision(16) << r.unixTime << std::setprecision(9) << ','
+        << r.tracker << ',' << r.errCode << ',' << r.flags << ',' << r.latitude << ',' << r.longitude << ','
+        << r.altitude << ',' << r.speed << ',' << r.imuSamples;
+    for (int i = 0; i < 3; i++)
+      out << ',' << r.accel[i];
+    for (int i = 0; i < 3; i++)
+      out << ',' << r.gyro[i];
+    for (int i = 0; i < 3; i++)
+      out << ',' << r.mag[i];
+    out << ',' << r.temperature << ',' << r.pressure << ',' << r.humidity << ',' << r.declination << ','
+        << r.heading << ',' << r.sunAzimuth << ',' << r.sunElevation << ',' << r.commandAzimuth << ','
+        << r.commandElevation << '\n';
+    rows++;
+  }
+  munmap(map, size);
+  if (records != nullptr)
+    *records = rows;
+  return out ? TELEMETRY_OK : TELEMETRY_NO_FILE;
+}
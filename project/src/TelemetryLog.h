@@ -0,0 +1,115 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <cstddef>
+#include <ostream>
+
+/*************************** LOG FORMAT ********************************************/
+/* First page of the file: this header. Records follow from TELEMETRY_DATA_OFFSET, a ring
+   of capacity fixed-size slots. Native byte order, like SensorLog. */
+struct TelemetryHeader
+{
+  char magic[8];       // "PSTTLM1"
+  uint32_t recordSize; // sizeof(TelemetryRecord)
+  uint32_t reserved;
+  uint64_t capacity;   // Slots in the ring
+  uint64_t head;       // Records ever reserved; record n (from 1) lives in slot (n - 1) % capacity
+};
+
+enum TELEMETRYFLAG
+{
+  TELEMETRY_IMU = 1,     // The tick fused IMU samples; the last one is in the record
+  TELEMETRY_GPS = 2,     // A GPS fix is known
+  TELEMETRY_SUN = 4,     // The sun (and declination, heading) were computed
+  TELEMETRY_COMMAND = 8, // A command or a planned move was sent
+};
+
+/* One control tick of one tracker: its inputs and outputs. 128 bytes, packed by hand. */
+struct TelemetryRecord
+{
+  uint64_t sequence; // Record number from 1, stored last; any other value marks a slot being written
+  double unixTime;   // Tick time [s]
+  double latitude;   // [degrees]
+  double longitude;  // [degrees]
+  uint32_t tracker;  // Index within a fleet, 0 for the daemon
+  int32_t errCode;   // Tick result: 0, TrackingCore::NOTREADY or an error code
+  uint32_t flags;    // TELEMETRYFLAG
+  uint32_t imuSamples; // IMU samples fused this tick
+  float altitude;    // [km]
+  float speed;       // GPS ground speed
+  float accel[3];    // Last fused IMU sample, IMUSensorData units
+  float gyro[3];
+  float mag[3];      // Calibrated
+  float temperature; // Weather in use
+  float pressure;
+  float humidity;
+  float declination; // [degrees]
+  float heading;     // True heading of the base [degrees]
+  float sunAzimuth;  // From true north [degrees]
+  float sunElevation; // [degrees]
+  float commandAzimuth; // Base frame [degrees]
+  float commandElevation;
+};
+static_assert(sizeof(TelemetryRecord) == 128, "TelemetryRecord must stay 128 bytes");
+/*************************** END LOG FORMAT ****************************************/
+
+enum TELEMETRYERROR
+{
+  TELEMETRY_OK = 0,
+  TELEMETRY_NO_FILE = -1,  // File could not be opened, sized or mapped
+  TELEMETRY_BAD_FILE = -2, // Not a telemetry log
+};
+
+/**
+ * @brief: Fixed-size circular telemetry log in a memory-mapped file. Append() is a
+ *         fetch-and-add for the slot and 128 bytes of stores into the page cache: no
+ *         syscall, no lock, any number of writer threads. The kernel writes the pages
+ *         back on its own, and they survive a crash of the process. The oldest records
+ *         are overwritten once the ring is full. Opening a log of the same geometry
+ *         continues it, so a restart keeps the history before it.
+ */
+class TelemetryLog
+{
+public:
+  static const std::size_t DATA_OFFSET = 4096;
+
+  TelemetryLog() : header_(nullptr), records_(nullptr), size_(0), errCode_(TELEMETRY_OK) {}
+  ~TelemetryLog() { Close(); }
+
+  TelemetryLog(const TelemetryLog &) = delete;
+  TelemetryLog &operator=(const TelemetryLog &) = delete;
+
+  /* Map (and size, or keep) path for capacity records; the pages are faulted in now */
+  int Open(const char *path, std::size_t capacity);
+  void Close();
+  bool IsOpen() const { return header_ != nullptr; }
+
+  /* Reserve the next slot and fill it; record.sequence is ignored and set here */
+  void Append(const TelemetryRecord &record)
+  {
+    uint64_t sequence = __atomic_add_fetch(&header_->head, 1, __ATOMIC_RELAXED);
+    TelemetryRecord &slot = records_[(sequence - 1) % header_->capacity];
+    // Invalidate, fill, then publish: a reader never takes a half-written slot
+    __atomic_store_n(&slot.sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    const std::size_t skip = sizeof(slot.sequence);
+    memcpy(reinterpret_cast<char *>(&slot) + skip, reinterpret_cast<const char *>(&record) + skip,
+           sizeof(TelemetryRecord) - skip);
+    __atomic_store_n(&slot.sequence, sequence, __ATOMIC_RELEASE);
+  }
+
+  int GetErrCode() const { return errCode_; }
+
+private:
+  TelemetryHeader *header_;
+  TelemetryRecord *records_;
+  std::size_t size_;
+  int errCode_;
+};
+
+/**
+ * @brief: Offline decoder: every complete record still in the ring, oldest first, as CSV
+ *         with a header line. Slots overwritten or cut mid-write are skipped. Returns a
+ *         TELEMETRYERROR; *records (if set) gets the number of rows written.
+ */
+int DecodeTelemetry(const char *path, std::ostream &out, std::size_t *records = nullptr);
@@ -0,0 +1,504 @@
+#pragma once
+#include <math.h>
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include "HeadingFusion.h"
+#include "HighResClock.h"
+#include "IActuator.h"
+#include "IGPSSensor.h"
+#include "IMUSensor.h"
+#include "IWeather.h"
+#include "MagCalibration.h"
+#include "MotionPlanner.h"
+#include "Probe.h"
+#include "SPAEphemeris.h"
+#include "SPALib.h"
+#include "SPARtsCache.h"
+#include "SPATrackingGate.h"
+#include "SPAWeatherFeed.h"
+#include "SensorLog.h"
+#include "TelemetryLog.h"
+#include "WMMLib.h"
+
+/* Clock policy over the virtual IDateTime interface: whole seconds, JD from the local time */
+class DateTimeClock
+{
+public:
+  explicit DateTimeClock(const IDateTime &source) : source_(source) {}
+
+  ClockTime Now() const
+  {
+    ClockTime now;
+    now.local = source_.GetDateTimeDate();
+    const Date &d = now.local.dt;
+    const Time &t = now.local.tt;
+    now.jdUtc = julian_day(d.year, d.month, d.date, t.hour, t.minute, t.second, 0.0, t.timezone);
+    now.unixTime = (now.jdUtc - 2440587.5) * 86400.0;
+    now.decimalYear = source_.GetDecimalYear();
+    return now;
+  }
+
+private:
+  const IDateTime &source_;
+};
+
+/**
+ * @brief: One control tick (sensors -> heading -> sun -> command) as a template over
+ *         its sources, so a build with concrete drivers gets the reads and the math
+ *         inlined into one loop body. The policies are duck-typed on the members used:
+ *           Imu      SampleSpan<const Timestamped<IMUSensorData>> GetIMUSamples()
+ *           Gps      SampleSpan<const Timestamped<Position>> GetPositionSamples()
+ *           Weather  SampleSpan<const Timestamped<WeatherData>> GetWeatherSamples()
+ *                    WeatherData GetWeatherData() const
+ *           Clock    ClockTime Now() const
+ *           Actuator int SendCommand(const double &azimuth, const double &elevation)
+ *                    int SendMove(const MoveCommand &move), with a MotionPlanner
+ *         Instantiated on IMUSensor, IGPSSensor, IWeather, DateTimeClock and IActuator
+ *         it is the virtual form, for tests and mixed builds. Declaring a driver final
+ *         is enough for the compiler to bind its calls statically.
+ *         The stages are separate calls so a caller can time them; Step() runs all four.
+ *         Each returns 0, an error code, or NOTREADY until an orientation and a GPS fix
+ *         are available. With a SensorRecorder attached every input the stages consume
+ *         and every command is logged, enough for SensorReplay to rerun the ticks.
+ *         With a MotionPlanner attached the sun is no longer sent every tick: the
+ *         planner decides when the dish moves and SendCommand() only sends its moves.
+ *         With a TelemetryLog attached each tick leaves one fixed-size record of its
+ *         inputs and outputs (Step() writes it; stage-by-stage callers use LogTelemetry()).
+ *         An SPATrackingGate sits in front of the sun and command stages: once the sun is
+ *         below GateConfig::minElevation the dish gets one stow command, then the steps
+ *         skip SPA and the actuator until the next sunrise (GetWakeTime()).
+ */
+template <typename Imu, typename Gps, typename Weather, typename Clock, typename Actuator>
+class TrackingCore
+{
+public:
+  static const int NOTREADY = -1;
+  static const std::size_t CAL_SOLVE_EVERY = 64; // Accepted calibration samples between solves
+  static constexpr double GATE_RELOCATE = 0.01;   // Fix move that re-solves the gate's day [degrees]
+
+  TrackingCore(Imu &imu, Gps &gps, Weather &weather, const Clock &clock, Actuator &actuator,
+               WMMEngine &wmm, double fusionGain = 0.1)
+      : imu_(imu), gps_(gps), weather_(weather), clock_(clock), actuator_(actuator), wmm_(wmm),
+        fusionGain_(fusionGain), fusion_(fusionGain), recorder_(nullptr), planner_(nullptr), ephemeris_(nullptr),
+        telemetry_(nullptr), tracker_(0), imuTime_(-1.0), imuCount_(0), sunDone_(false), commandSent_(false),
+        commandAzimuth_(0.0), commandElevation_(0.0),
+        calSolvedAt_(0), posValid_(false), declination_(0.0), declinationDay_(0, 0, 0),
+        heading_(0.0), engine_(nullptr), sun_(), rtsCache_(nullptr), gate_(nullptr), gateDecision_() {}
+  ~TrackingCore()
+  {
+    delete gate_;
+    delete engine_;
+  }
+
+  TrackingCore(const TrackingCore &) = delete;
+  TrackingCore &operator=(const TrackingCore &) = delete;
+
+  /* Log the run from here on; attach before the first step, after loading the calibration
+     and attaching the planner */
+  void SetRecorder(SensorRecorder *recorder)
+  {
+    recorder_ = recorder;
+    if (recorder_ == nullptr)
+      return;
+    std::ostringstream calibration;
+    magCal_.Save(calibration);
+    recorder_->BeginSession(fusionGain_, calibration.str().c_str());
+    if (planner_ != nullptr)
+      recorder_->Record(planner_->GetConfig());
+  }
+
+  /* Send planned moves instead of a command per tick; attach before the first step */
+  void SetPlanner(MotionPlanner *planner) { planner_ = planner; }
+
+  /* Take the geocentric sun terms from an ephemeris shared with other cores instead of a
+     full SPA series per step; only the site's topocentric stage runs here. The ephemeris
+     must cover the times stepped (and looked ahead to) and not change during a step. */
+  void SetEphemeris(const SPAEphemeris *ephemeris) { ephemeris_ = ephemeris; }
+
+  /* Sun threshold and stow position of the night gate; set before the first step */
+  void SetGate(const GateConfig &config) { gateConfig_ = config; }
+
+  /* Solve the gate's days on a cache shared with other cores instead of one of the core's
+     own, made on the first step otherwise; set before the first step */
+  void SetRtsCache(SPARtsCache *cache) { rtsCache_ = cache; }
+
+  /* Append every tick's inputs and outputs to a telemetry ring as tracker */
+  void SetTelemetry(TelemetryLog *telemetry, uint32_t tracker)
+  {
+    telemetry_ = telemetry;
+    tracker_ = tracker;
+  }
+
+  int Step()
+  {
+    PROBE_SCOPE(PROBE_TICK);
+    int errCode = ReadSensors();
+    if (errCode == 0)
+      errCode = UpdateHeading();
+    if (errCode == 0)
+      errCode = UpdateSun();
+    if (errCode == 0)
+      errCode = SendCommand();
+    LogTelemetry(errCode);
+    return errCode;
+  }
+
+  /* End of a tick run stage by stage: one telemetry record, if a log is attached */
+  void LogTelemetry(int errCode)
+  {
+    if (telemetry_ == nullptr)
+      return;
+    TelemetryRecord r;
+    r.sequence = 0;
+    r.unixTime = now_.unixTime;
+    r.latitude = pos_.Latitude;
+    r.longitude = pos_.Longitude;
+    r.tracker = tracker_;
+    r.errCode = errCode;
+    r.flags = (imuCount_ > 0 ? TELEMETRY_IMU : 0) | (posValid_ ? TELEMETRY_GPS : 0) |
+              (sunDone_ ? TELEMETRY_SUN : 0) | (commandSent_ ? TELEMETRY_COMMAND : 0);
+    r.imuSamples = static_cast<uint32_t>(imuCount_);
+    r.altitude = static_cast<float>(pos_.Altitude);
+    r.speed = static_cast<float>(pos_.Speed);
+    const Point3f *v[3] = {&lastImu_.accel, &lastImu_.gyro, &lastImu_.mag};
+    float *f[3] = {r.accel, r.gyro, r.mag};
+    for (int i = 0; i < 3; i++)
+    {
+      f[i][0] = static_cast<float>(v[i]->X);
+      f[i][1] = static_cast<float>(v[i]->Y);
+      f[i][2] = static_cast<float>(v[i]->Z);
+    }
+    r.temperature = static_cast<float>(weatherInUse_.temp);
+    r.pressure = static_cast<float>(weatherInUse_.presure);
+    r.humidity = static_cast<float>(weatherInUse_.humidity);
+    r.declination = static_cast<float>(declination_);
+    r.heading = static_cast<float>(heading_);
+    r.sunAzimuth = static_cast<float>(sun_.pos.azimuth);
+    r.sunElevation = static_cast<float>(90.0 - sun_.pos.zenith);
+    r.commandAzimuth = static_cast<float>(commandAzimuth_);
+    r.commandElevation = static_cast<float>(commandElevation_);
+    telemetry_->Append(r);
+  }
+
+  /* Take the IMU view (zero copy, consumed by UpdateHeading()), the newest fix and the time */
+  int ReadSensors()
+  {
+    PROBE_SCOPE(PROBE_SENSORS);
+    imuView_ = imu_.GetIMUSamples();
+    imuCount_ = imuView_.size;
+    sunDone_ = false;
+    commandSent_ = false;
+    SampleSpan<const Timestamped<Position>> fixes = gps_.GetPositionSamples();
+    if (fixes.size > 0)
+    {
+      pos_ = fixes[fixes.size - 1].data;
+      posValid_ = true;
+    }
+    now_ = clock_.Now();
+    if (recorder_ != nullptr)
+    {
+      recorder_->BeginTick();
+      for (const Timestamped<IMUSensorData> &s : imuView_)
+        recorder_->Record(s);
+      for (const Timestamped<Position> &f : fixes)
+        recorder_->Record(f);
+      recorder_->Record(now_);
+    }
+    return 0;
+  }
+
+  /* Calibrate and fuse every IMU sample at its own time step, then apply the declination */
+  int UpdateHeading()
+  {
+    PROBE_SCOPE(PROBE_HEADING);
+    PROBE_COUNT(COUNTER_IMU_SAMPLES, imuView_.size);
+    for (const Timestamped<IMUSensorData> &s : imuView_)
+    {
+      IMUSensorData data = s.data;
+      magCal_.Add(data.mag);
+      data.mag = magCal_.Apply(data.mag);
+      fusion_.Update(data, imuTime_ < 0.0 ? 0.0 : s.time - imuTime_);
+      lastImu_ = data;
+      imuTime_ = s.time;
+    }
+    imuView_ = SampleSpan<const Timestamped<IMUSensorData>>();
+    // Re-solve once the WMM reference radius is known and enough new samples arrived
+    if (declinationDay_.year != 0 && magCal_.GetSamples() >= calSolvedAt_ + CAL_SOLVE_EVERY)
+    {
+      magCal_.Solve();
+      calSolvedAt_ = magCal_.GetSamples();
+    }
+    if (!fusion_.IsSeeded() || !posValid_)
+      return NOTREADY;
+    int errCode = UpdateDeclination();
+    if (errCode != 0)
+      return errCode;
+    heading_ = fusion_.GetTrueHeading();
+    return 0;
+  }
+
+  /* The engine is compiled once per site and only rebuilt when the GPS fix moves; weather
+     goes through the feed's filter and only recompiles it when the filtered value moved.
+     Outside the gate's window no sun is computed and 0 is returned. */
+  int UpdateSun()
+  {
+    PROBE_SCOPE(PROBE_SUN);
+    SampleSpan<const Timestamped<WeatherData>> weather;
+    {
+      PROBE_SCOPE(PROBE_WEATHER_READ);
+      weather = weather_.GetWeatherSamples();
+    }
+    Timestamped<WeatherData> fallback;
+    bool rebuild = engine_ == nullptr || pos_.Latitude != site_.Latitude ||
+                   pos_.Longitude != site_.Longitude || pos_.Altitude != site_.Altitude;
+    if (rebuild && weather.size == 0 && !weatherFeed_.IsPrimed())
+    {
+      // A new engine needs some weather: take the source's current value. Should the feed
+      // reject it, the engine is built on the feed's standard atmosphere instead
+      fallback = Timestamped<WeatherData>(MonotonicNow(), weather_.GetWeatherData());
+      weather = SampleSpan<const Timestamped<WeatherData>>(&fallback, 1);
+    }
+    if (recorder_ != nullptr)
+    {
+      for (const Timestamped<WeatherData> &w : weather)
+        recorder_->Record(w);
+    }
+    if (rebuild)
+      weatherFeed_.SetEngine(nullptr);
+    for (const Timestamped<WeatherData> &w : weather)
+      weatherFeed_.Add(w.data, w.time);
+    if (rebuild)
+      Relocate();
+    weatherInUse_ = engine_->GetSite().weather;
+    gateDecision_ = gate_->Check(now_.local);
+    if (gateDecision_.state != GATE_TRACKING)
+      return gateDecision_.errCode;
+    sun_ = GetSunPosition(now_.jdUtc);
+    sunDone_ = sun_.errCode == 0;
+    return sun_.errCode;
+  }
+
+  /* Sun azimuth measured from true north, moved into the base frame; the stow position
+     once when the gate closes, nothing while it sleeps */
+  int SendCommand()
+  {
+    PROBE_SCOPE(PROBE_COMMAND);
+    if (gateDecision_.state == GATE_STOWING)
+      return gateDecision_.sendCommand ? SendStow() : 0;
+    if (gateDecision_.state != GATE_TRACKING)
+      return 0;
+    double azimuth = ToBase(sun_.pos.azimuth);
+    double elevation = 90.0 - sun_.pos.zenith;
+    if (planner_ != nullptr)
+    {
+      MoveCommand move;
+      if (!planner_->Update(now_.unixTime, azimuth, elevation, GetPredictor(), &move))
+        return 0;
+      gate_->CountCommand();
+      return SendMove(move);
+    }
+    gate_->CountCommand();
+    return SendDirect(azimuth, elevation);
+  }
+
+  /**
+   * @brief: Latest time [s, Unix] the next step is needed by, at most maxInterval after
+   *         the last one: from the planner's predicted deadband crossing. Without a
+   *         planner, or before the first sun position, that is the last step's time.
+   *         While the gate sleeps it is the wake time, whatever maxInterval says.
+   */
+  double GetNextUpdate(double maxInterval) const
+  {
+    if (gateDecision_.state != GATE_TRACKING)
+      return GetWakeTime();
+    if (planner_ == nullptr || engine_ == nullptr)
+      return now_.unixTime;
+    return planner_->GetNextUpdate(now_.unixTime, GetPredictor(), maxInterval);
+  }
+
+  MagCalibration &GetMagCalibration() { return magCal_; }
+  const MagCalibration &GetMagCalibration() const { return magCal_; }
+  void MarkCalibrationSolved() { calSolvedAt_ = magCal_.GetSamples(); }
+
+  double GetDeclination() const { return declination_; }
+  double GetTrueHeading() const { return heading_; }
+  const Quaternion &GetQuaternion() const { return fusion_.GetQuaternion(); }
+  const SunData &GetSun() const { return sun_; }
+  /* Time of the last fused IMU sample, negative before the first */
+  double GetImuTime() const { return imuTime_; }
+
+  /* GATESTATE of the last step, and the gate's counters (empty before the first sun stage) */
+  int GetGateState() const { return gateDecision_.state; }
+  GateStats GetGateStats() const { return gate_ != nullptr ? gate_->GetStats() : GateStats(); }
+  /* Time [s, Unix] the gate opens again; the last step's time while tracking */
+  double GetWakeTime() const { return now_.unixTime + gateDecision_.wakeIn; }
+
+private:
+  double ToBase(double azimuth) const
+  {
+    azimuth = fmod(azimuth - heading_, 360.0);
+    return azimuth < 0.0 ? azimuth + 360.0 : azimuth;
+  }
+
+  SunData GetSunPosition(double jdUtc) const
+  {
+    if (ephemeris_ == nullptr)
+      return engine_->GetSunPosition(jdUtc);
+    SunData sun;
+    double jd, deltaT;
+    sun.errCode = engine_->GetJulianDayUtc(jdUtc, &jd, &deltaT);
+    if (sun.errCode == 0)
+    {
+      SunNode node;
+      ephemeris_->GetSunNode(jd, &node);
+      engine_->GetTopocentric(jd, node, &sun.pos);
+    }
+    return sun;
+  }
+
+  /* The planner looks ahead on the site's engine, at the current heading */
+  MotionPlanner::Predictor GetPredictor() const
+  {
+    return [this](double time, double *az, double *el) {
+      SunData sun = GetSunPosition(now_.jdUtc + (time - now_.unixTime) / 86400.0);
+      *az = ToBase(sun.pos.azimuth);
+      *el = 90.0 - sun.pos.zenith;
+      return sun.errCode == 0;
+    };
+  }
+
+  void SetCommand(double azimuth, double elevation)
+  {
+    commandSent_ = true;
+    commandAzimuth_ = azimuth;
+    commandElevation_ = elevation;
+  }
+
+  /* First engine for the site, else recompiled in place so the gate bound to it keeps
+     its state; the gate re-solves its day only once the fix really moved */
+  void Relocate()
+  {
+    SPALib engine(SiteData(pos_, weatherFeed_.GetFiltered()));
+    if (engine_ == nullptr)
+    {
+      if (rtsCache_ == nullptr)
+      {
+        ownRtsCache_.reset(new SPARtsCache());
+        rtsCache_ = ownRtsCache_.get();
+      }
+      engine_ = new SPALib(engine);
+      gate_ = new SPATrackingGate(*engine_, *rtsCache_, gateConfig_);
+      gateSite_ = pos_;
+    }
+    else
+    {
+      *engine_ = engine;
+      if (fabs(pos_.Latitude - gateSite_.Latitude) > GATE_RELOCATE ||
+          fabs(pos_.Longitude - gateSite_.Longitude) > GATE_RELOCATE)
+      {
+        gate_->Relocate();
+        gateSite_ = pos_;
+      }
+    }
+    weatherFeed_.SetEngine(engine_);
+    site_ = pos_;
+  }
+
+  int SendStow()
+  {
+    double azimuth = ToBase(gateDecision_.target.azimuth);
+    double elevation = 90.0 - gateDecision_.target.zenith;
+    if (planner_ == nullptr)
+      return SendDirect(azimuth, elevation);
+    MoveCommand move;
+    planner_->MoveTo(now_.unixTime, azimuth, elevation, &move);
+    return SendMove(move);
+  }
+
+  int SendDirect(double azimuth, double elevation)
+  {
+    int errCode = actuator_.SendCommand(azimuth, elevation);
+    PROBE_COUNT(COUNTER_MOVES, 1);
+    SetCommand(azimuth, elevation);
+    if (recorder_ != nullptr)
+      recorder_->RecordCommand(azimuth, elevation, errCode);
+    return errCode;
+  }
+
+  int SendMove(const MoveCommand &move)
+  {
+    int errCode = actuator_.SendMove(move);
+    PROBE_COUNT(COUNTER_MOVES, 1);
+    SetCommand(move.azimuth, move.elevation);
+    if (recorder_ != nullptr)
+      recorder_->RecordCommand(move.azimuth, move.elevation, errCode);
+    return errCode;
+  }
+
+  /* Secular variation is a few arc minutes a year: once per local day is plenty */
+  int UpdateDeclination()
+  {
+    const Date &day = now_.local.dt;
+    if (declinationDay_.year != 0 && day.year == declinationDay_.year &&
+        day.month == declinationDay_.month && day.date == declinationDay_.date)
+      return 0;
+
+    InData in;
+    in.decimalYear = now_.decimalYear;
+    in.pos = pos_;
+    DecData decl = wmm_.GetDeclination(in);
+    if (decl.errCode != NOERROR)
+      return decl.errCode;
+    declination_ = decl.magData.D;
+    declinationDay_ = day;
+    magCal_.SetReference(decl.magData.F);
+    fusion_.SetDeclination(declination_);
+    return 0;
+  }
+
+  Imu &imu_;
+  Gps &gps_;
+  Weather &weather_;
+  const Clock &clock_;
+  Actuator &actuator_;
+  WMMEngine &wmm_;
+
+  double fusionGain_;
+  HeadingFusion fusion_;
+  MagCalibration magCal_;
+  SensorRecorder *recorder_;
+  MotionPlanner *planner_;
+  const SPAEphemeris *ephemeris_;
+  TelemetryLog *telemetry_;
+  uint32_t tracker_;
+  SampleSpan<const Timestamped<IMUSensorData>> imuView_;
+  double imuTime_;
+  std::size_t imuCount_; // Samples in this tick
+  IMUSensorData lastImu_; // Last one fused, calibrated
+  SPAWeatherFeed weatherFeed_;
+  WeatherData weatherInUse_; // What the engine's refraction uses
+  bool sunDone_;     // This tick
+  bool commandSent_; // This tick, at commandAzimuth_/commandElevation_ (held from the last one)
+  double commandAzimuth_;
+  double commandElevation_;
+  std::size_t calSolvedAt_;
+
+  ClockTime now_;
+  Position pos_;
+  bool posValid_;
+  double declination_;
+  Date declinationDay_;
+  double heading_;
+
+  Position site_;
+  SPALib *engine_;
+  SunData sun_;
+
+  GateConfig gateConfig_;
+  SPARtsCache *rtsCache_;
+  std::unique_ptr<SPARtsCache> ownRtsCache_; // Without a shared one
+  SPATrackingGate *gate_;      // Bound to *engine_, built with it
+  Position gateSite_;          // Site the gate's windows were solved for
+  GateDecision gateDecision_;  // Of the last sun stage
+};
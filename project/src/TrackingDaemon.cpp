@@ -0,0 +1,242 @@
+#include "TrackingDaemon.h"
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+  const double NSEC = 1e9;
+
+  const char *const STAGE_NAMES[STAGE_COUNT] = {"wake", "sensors", "heading", "sun", "command", "tick", "age"};
+
+  double ToSeconds(const struct timespec &ts)
+  {
+    return ts.tv_sec + ts.tv_nsec / NSEC;
+  }
+
+  void AddNanoseconds(struct timespec *ts, long long ns)
+  {
+    long long total = ts->tv_nsec + ns;
+    ts->tv_sec += static_cast<time_t>(total / static_cast<long long>(NSEC));
+    ts->tv_nsec = static_cast<long>(total % static_cast<long long>(NSEC));
+  }
+
+  void SetSeconds(struct timespec *ts, double seconds)
+  {
+    ts->tv_sec = static_cast<time_t>(floor(seconds));
+    ts->tv_nsec = static_cast<long>((seconds - floor(seconds)) * NSEC);
+  }
+
+  const char *GateName(int state)
+  {
+    return state == GATE_TRACKING ? "tracking" : (state == GATE_STOWING ? "stowing" : "asleep");
+  }
+} // namespace
+
+int TrackingDaemon::Run()
+{
+  if (config_.rate <= 0.0)
+    return INPUTERROR;
+  if (wmm_.GetErrCode() != NOERROR)
+    return wmm_.GetErrCode();
+
+  int errCode = imu_.Initialize();
+  if (errCode == 0)
+    errCode = gps_.Initialize();
+  if (errCode == 0)
+    errCode = actuator_.Initialize();
+  if (errCode != 0)
+    return errCode;
+  MagCalibration &magCal = core_.GetMagCalibration();
+  if (config_.magCalFile != nullptr && magCal.Load(config_.magCalFile) == MagCalibration::CAL_BAD_FILE)
+    std::cerr << "Ignoring unreadable magnetometer calibration " << config_.magCalFile << std::endl;
+  core_.MarkCalibrationSolved();
+  if (config_.deadband > 0.0)
+    core_.SetPlanner(&planner_);
+  if (config_.recordFile != nullptr)
+  {
+    if (recorder_.Open(config_.recordFile) != LOG_OK)
+    {
+      std::cerr << "Could not open sensor log " << config_.recordFile << std::endl;
+      return FILEERROR;
+    }
+    core_.SetRecorder(&recorder_);
+  }
+  if (config_.telemetryFile != nullptr)
+  {
+    if (telemetry_.Open(config_.telemetryFile, config_.telemetryRecords) != TELEMETRY_OK)
+    {
+      std::cerr << "Could not map telemetry log " << config_.telemetryFile << std::endl;
+      return FILEERROR;
+    }
+    core_.SetTelemetry(&telemetry_, 0);
+  }
+  if (!imuSampler_.Start() || !gpsSampler_.Start())
+    return INPUTERROR;
+  if (config_.imuRate / config_.rate > IMU_RING)
+    std::cerr << "IMU rate exceeds " << IMU_RING << " samples per tick: "
+              << "the ring will overrun and drop the oldest samples of each tick" << std::endl;
+
+  const long long period = static_cast<long long>(NSEC / config_.rate);
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  const double start = ToSeconds(deadline);
+  double nextReport = start + config_.reportInterval;
+  std::size_t reported = 0;
+
+  while (!stop_)
+  {
+    int rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+    if (rc == EINTR)
+      continue; // Signal: re-check stop_, then sleep out the same deadline
+    if (stop_)
+      break;
+
+    const double due = ToSeconds(deadline);
+    const double woke = MonotonicNow();
+    stages_[STAGE_WAKE].Add(woke - due);
+
+    errCode = Tick();
+    const bool asleep = errCode == 0 && core_.GetGateState() != GATE_TRACKING;
+    if (errCode == Core::NOTREADY)
+      skipped_++;
+    else if (errCode != 0)
+    {
+      // A failed tick (a bad reading, an actuator fault) is retried on the next deadline;
+      // only a change of error is printed so a persistent fault does not flood the log
+      if (errCode != lastError_)
+        std::cerr << "An Error occurred: " << errCode << " While running tick " << ticks_ + errors_
+                  << ", retrying every period" << std::endl;
+      errors_++;
+      lastError_ = errCode;
+    }
+    else
+    {
+      ticks_++;
+      lastError_ = 0;
+    }
+    errCode = 0;
+
+    const double done = MonotonicNow();
+    stages_[STAGE_TICK].Add(done - due);
+
+    AddNanoseconds(&deadline, period);
+    if (asleep)
+    {
+      // Gate closed: sleep to the sunrise, still waking for the reports and the end of the run
+      double wake = done + core_.GetWakeTime() - clock_.Now().unixTime;
+      if (config_.reportInterval > 0.0)
+        wake = fmin(wake, nextReport);
+      if (config_.duration > 0.0)
+        wake = fmin(wake, start + config_.duration);
+      SetSeconds(&deadline, fmax(wake, ToSeconds(deadline)));
+    }
+    else if (done > ToSeconds(deadline))
+    {
+      // Overran into the next period: drop the deadlines already passed
+      long long behind = static_cast<long long>((done - ToSeconds(deadline)) * NSEC);
+      long long skipped = behind / period + 1;
+      missed_ += static_cast<std::size_t>(skipped);
+      PROBE_COUNT(COUNTER_MISSED, skipped);
+      AddNanoseconds(&deadline, skipped * period);
+      std::cerr << "Tick " << ticks_ << " missed its deadline by "
+                << (done - due) * 1e3 - period / 1e6 << " ms, skipped "
+                << skipped << " period(s)" << std::endl;
+    }
+
+    if (config_.reportInterval > 0.0 && done >= nextReport)
+    {
+      Report();
+      reported = ticks_;
+      nextReport += config_.reportInterval * (floor((done - nextReport) / config_.reportInterval) + 1.0);
+    }
+    if (config_.duration > 0.0 && done - start >= config_.duration)
+      break;
+  }
+
+  imuSampler_.Stop();
+  gpsSampler_.Stop();
+  if (config_.recordFile != nullptr && recorder_.Close() != LOG_OK)
+    std::cerr << "Sensor log " << config_.recordFile << " is incomplete" << std::endl;
+  if (config_.magCalFile != nullptr && magCal.GetSamples() > 0 &&
+      magCal.Save(config_.magCalFile) != MagCalibration::CAL_OK)
+    std::cerr << "Could not save magnetometer calibration " << config_.magCalFile << std::endl;
+  if (reported != ticks_ || ticks_ == 0)
+    Report(); // Exit summary, unless the last periodic report already covers it
+  return errCode;
+}
+
+int TrackingDaemon::Tick()
+{
+  PROBE_SCOPE(PROBE_TICK);
+  int errCode = RunStages();
+  core_.LogTelemetry(errCode);
+  return errCode;
+}
+
+int TrackingDaemon::RunStages()
+{
+  double t0 = MonotonicNow();
+  int errCode = core_.ReadSensors();
+  double t1 = MonotonicNow();
+  stages_[STAGE_SENSORS].Add(t1 - t0);
+  if (errCode == 0)
+    errCode = core_.UpdateHeading();
+  if (errCode != 0)
+    return errCode;
+  double t2 = MonotonicNow();
+  stages_[STAGE_HEADING].Add(t2 - t1);
+
+  errCode = core_.UpdateSun();
+  if (errCode != 0)
+    return errCode;
+  double t3 = MonotonicNow();
+  stages_[STAGE_SUN].Add(t3 - t2);
+
+  errCode = core_.SendCommand();
+  double t4 = MonotonicNow();
+  stages_[STAGE_COMMAND].Add(t4 - t3);
+  stages_[STAGE_AGE].Add(t4 - core_.GetImuTime());
+  return errCode;
+}
+
+void TrackingDaemon::Report() const
+{
+  std::cout << "Ticks: " << ticks_ << ", Missed deadlines: " << missed_
+            << ", Skipped: " << skipped_ << ", Errors: " << errors_;
+  if (lastError_ != 0)
+    std::cout << " (failing with " << lastError_ << ")";
+  std::cout << ", Declinition: " << core_.GetDeclination() << std::endl;
+  GateStats gate = core_.GetGateStats();
+  std::cout << "  Sun gate: " << GateName(core_.GetGateState());
+  if (core_.GetGateState() != GATE_TRACKING)
+    std::cout << " for " << core_.GetWakeTime() - clock_.Now().unixTime << " s more";
+  std::cout << ", today SPA runs: " << gate.spaEvaluations << " (saved " << gate.spaSaved
+            << "), commands: " << gate.commands << " (saved " << gate.commandsSaved << ")" << std::endl;
+  std::cout << "  IMU samples: " << imuSampler_.GetSamples() << ", overruns: " << imuSampler_.GetOverruns()
+            << ", underruns: " << imuSampler_.GetUnderruns() << ", GPS samples: " << gpsSampler_.GetSamples()
+            << std::endl;
+  const MagCalibration &magCal = core_.GetMagCalibration();
+  std::cout << "  Magnetometer calibration: " << (magCal.IsValid() ? "valid" : "not valid")
+            << ", samples: " << magCal.GetSamples() << std::endl;
+  if (config_.deadband > 0.0)
+  {
+    const PlannerStats &p = planner_.GetStats();
+    std::cout << "  Moves: " << p.commands << " (" << p.GetCommandsPerHour() << " per hour, moving "
+              << p.moving << " s), pointing error RMS " << p.GetRmsError() << " deg, max "
+              << p.maxError << " deg" << std::endl;
+  }
+  for (int i = 0; i < STAGE_COUNT; i++)
+  {
+    const StageStats &s = stages_[i];
+    double mean = s.count ? s.total / s.count : 0.0;
+    std::cout << "  " << std::left << std::setw(8) << STAGE_NAMES[i] << std::right << std::fixed
+              << std::setprecision(1) << " last " << std::setw(9) << s.last * 1e6
+              << " us, mean " << std::setw(9) << mean * 1e6
+              << " us, max " << std::setw(9) << s.max * 1e6 << " us" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+  }
+}
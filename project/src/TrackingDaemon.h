@@ -0,0 +1,175 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include "HighResClock.h"
+#include "IActuator.h"
+#include "IGPSSensor.h"
+#include "IMUSensor.h"
+#include "IWeather.h"
+#include "Probe.h"
+#include "SensorLog.h"
+#include "SensorSampler.h"
+#include "TelemetryLog.h"
+#include "TrackingCore.h"
+#include "WMMLib.h"
+
+/*************************** USER INPUT DATA ***************************************/
+struct DaemonConfig
+{
+  double rate;           // Control loop rate [Hz]
+  double duration;       // Run time [s], 0 runs until Stop()
+  double reportInterval; // Seconds between latency reports, 0 for none
+  double imuRate;        // IMU sampling thread rate [Hz]
+  double gpsRate;        // GPS sampling thread rate [Hz]
+  double fusionGain;     // Madgwick beta, see HeadingFusion [rad/s]
+  const char *magCalFile; // Persisted magnetometer calibration, nullptr for none
+  const char *recordFile; // SensorRecorder log appended to, nullptr for none
+  double deadband;       // MotionPlanner pointing deadband [degrees], 0 commands every tick
+  const char *telemetryFile;     // TelemetryLog ring, nullptr for none
+  std::size_t telemetryRecords;  // Ring capacity [records]
+  DaemonConfig(const double &r = 1.0, const double &d = 0.0, const double &i = 60.0,
+               const double &ir = 100.0, const double &gr = 1.0, const double &b = 0.1,
+               const char *m = nullptr, const char *rec = nullptr, const double &db = 0.1,
+               const char *tel = nullptr, const std::size_t &tr = 131072)
+      : rate(r), duration(d), reportInterval(i), imuRate(ir), gpsRate(gr), fusionGain(b),
+        magCalFile(m), recordFile(rec), deadband(db), telemetryFile(tel), telemetryRecords(tr) {}
+};
+/*************************** END USER INPUT DATA ***********************************/
+
+/*************************** USER OUTPUT DATA **************************************/
+enum STAGE
+{
+  STAGE_WAKE = 0, // Wake-up lateness after the absolute deadline
+  STAGE_SENSORS,  // Drain the IMU + GPS sample rings
+  STAGE_HEADING,  // Orientation fusion of the drained samples, declination
+  STAGE_SUN,      // Sun position
+  STAGE_COMMAND,  // Motion planning and actuator command
+  STAGE_TICK,     // Deadline to end of tick
+  STAGE_AGE,      // Newest fused IMU sample to actuator command
+  STAGE_COUNT,
+};
+
+struct StageStats
+{
+  std::size_t count;
+  double total; // [s]
+  double max;   // [s]
+  double last;  // [s]
+  StageStats() : count(0), total(0.0), max(0.0), last(0.0) {}
+  void Add(double seconds)
+  {
+    count++;
+    total += seconds;
+    last = seconds;
+    if (seconds > max)
+      max = seconds;
+  }
+};
+/*************************** END USER OUTPUT DATA ***********************************/
+
+/* TrackingCore Imu policy over a sampler ring: drains everything new, no virtual calls */
+template <std::size_t Capacity>
+class SampledIMU
+{
+public:
+  explicit SampledIMU(SensorSampler<IMUSensorData, Capacity> &sampler) : sampler_(sampler) {}
+  SampleSpan<const Timestamped<IMUSensorData>> GetIMUSamples()
+  {
+    return SampleSpan<const Timestamped<IMUSensorData>>(buffer_, sampler_.DrainLatest(buffer_, Capacity));
+  }
+
+private:
+  SensorSampler<IMUSensorData, Capacity> &sampler_;
+  Timestamped<IMUSensorData> buffer_[Capacity];
+};
+
+/* TrackingCore Gps policy over a sampler ring: the newest fix only */
+class SampledGPS
+{
+public:
+  explicit SampledGPS(SensorSampler<Position> &sampler) : sampler_(sampler) {}
+  SampleSpan<const Timestamped<Position>> GetPositionSamples()
+  {
+    return SampleSpan<const Timestamped<Position>>(&latest_, sampler_.DrainLatest(&latest_, 1));
+  }
+
+private:
+  SensorSampler<Position> &sampler_;
+  Timestamped<Position> latest_;
+};
+
+/**
+ * @brief: Long-running tracking service: a fixed-rate loop on CLOCK_MONOTONIC absolute
+ *         deadlines (clock_nanosleep), so the period does not drift with the tick's own
+ *         run time. The IMU and GPS are read by their own SensorSampler threads. Every
+ *         tick runs the TrackingCore stages over the drained rings: magnetometer
+ *         calibration (loaded at start, saved on exit), orientation fusion, sun and
+ *         command, each one timed, and optionally logged for replay. With a deadband the
+ *         dish is only moved when the MotionPlanner says so. A tick that overruns its period is logged and the
+ *         schedule skips to the next deadline still ahead rather than bursting to catch up.
+ *         A tick that fails is counted and retried on the next deadline; only a failed
+ *         start ends Run(). Once the core's sun gate has stowed the dish for the night
+ *         the loop sleeps until sunrise, waking only for the reports; the samplers keep
+ *         running meanwhile and their rings just overrun to the newest samples.
+ */
+class TrackingDaemon
+{
+public:
+  static const std::size_t IMU_RING = 128; // Must hold one tick of samples
+
+  typedef TrackingCore<SampledIMU<IMU_RING>, SampledGPS, IWeather, HighResClock, IActuator> Core;
+
+  TrackingDaemon(const DaemonConfig &config, IMUSensor &imu, IGPSSensor &gps,
+                 IWeather &weather, WMMEngine &wmm, IActuator &actuator)
+      : config_(config), imu_(imu), gps_(gps), wmm_(wmm), actuator_(actuator),
+        imuSampler_([&imu]() { PROBE_SCOPE(PROBE_IMU_READ); imu.GetRawSensorData(); return imu.GetIMUSamples(); },
+                    config.imuRate),
+        gpsSampler_([&gps]() { PROBE_SCOPE(PROBE_GPS_READ); gps.GetRawSensorData(); return gps.GetPositionSamples(); },
+                    config.gpsRate),
+        imuSource_(imuSampler_), gpsSource_(gpsSampler_),
+        core_(imuSource_, gpsSource_, weather, clock_, actuator, wmm, config.fusionGain),
+        planner_(PlannerConfig(config.deadband, 1.0 / config.rate)),
+        stop_(false), ticks_(0), missed_(0), skipped_(0), errors_(0), lastError_(0) {}
+
+  /* Run until the duration elapses or Stop() is called. Returns 0, or the error code of a
+     failed start; errors of single ticks are counted and reported, the loop keeps going. */
+  int Run();
+
+  /* Safe to call from a signal handler */
+  void Stop() { stop_ = true; }
+
+  const StageStats &GetStageStats(int stage) const { return stages_[stage]; }
+  std::size_t GetTicks() const { return ticks_; }
+  std::size_t GetMissed() const { return missed_; }
+  std::size_t GetErrors() const { return errors_; }
+  std::size_t GetImuOverruns() const { return imuSampler_.GetOverruns(); }
+  std::size_t GetImuUnderruns() const { return imuSampler_.GetUnderruns(); }
+
+private:
+  int Tick(); // 0, an error code, or Core::NOTREADY while the samplers have not delivered yet
+  int RunStages();
+  void Report() const;
+
+  DaemonConfig config_;
+  IMUSensor &imu_;
+  IGPSSensor &gps_;
+  WMMEngine &wmm_;
+  IActuator &actuator_;
+  HighResClock clock_;
+  SensorSampler<IMUSensorData, IMU_RING> imuSampler_;
+  SensorSampler<Position> gpsSampler_;
+  SampledIMU<IMU_RING> imuSource_;
+  SampledGPS gpsSource_;
+  Core core_;
+  MotionPlanner planner_;
+  SensorRecorder recorder_;
+  TelemetryLog telemetry_;
+
+  std::atomic<bool> stop_;
+  std::size_t ticks_;
+  std::size_t missed_;
+  std::size_t skipped_; // Ticks without an orientation or a GPS fix yet
+  std::size_t errors_;  // Ticks that failed with an error code
+  int lastError_;       // Code of the last failed tick, 0 for none
+  StageStats stages_[STAGE_COUNT];
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <vector>
+
+/**
+ * @brief: Wake-up times of many trackers as a binary min-heap: O(log n) to schedule,
+ *         and a wake-up only touches the trackers that are due. Each tracker is meant to
+ *         be in the heap once; it is popped when due and scheduled again after its step.
+ */
+class UpdateScheduler
+{
+public:
+  void Schedule(double time, std::size_t tracker) { heap_.push(Entry(time, tracker)); }
+
+  bool IsEmpty() const { return heap_.empty(); }
+  std::size_t GetSize() const { return heap_.size(); }
+  /* Earliest wake-up, undefined when empty */
+  double GetNextTime() const { return heap_.top().time; }
+
+  /* Append every tracker due at or before time to out, earliest first. Returns the count. */
+  std::size_t PopDue(double time, std::vector<std::size_t> *out)
+  {
+    std::size_t count = 0;
+    while (!heap_.empty() && heap_.top().time <= time)
+    {
+      out->push_back(heap_.top().tracker);
+      heap_.pop();
+      count++;
+    }
+    return count;
+  }
+
+private:
+  struct Entry
+  {
+    double time;
+    std::size_t tracker;
+    Entry(const double &t, const std::size_t &i) : time(t), tracker(i) {}
+    bool operator>(const Entry &other) const { return time > other.time; }
+  };
+
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap_;
+};
@@ -1,34 +1,259 @@
-#include <math.h>
-#include "WMMLib.h"
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
 #include <iostream>
+#include <vector>
+#include "CoreBenchmark.h"
+#include "FleetController.h"
+#include "ProbeReport.h"
+#include "SensorReplay.h"
+#include "TrackingDaemon.h"
 
-int main()
+static TrackingDaemon *daemon_ = nullptr;
+static FleetController *fleet_ = nullptr;
+
+/* Dumps the probes when main returns, whichever mode ran */
+class ProbeDumpAtExit
+{
+public:
+  explicit ProbeDumpAtExit(const char *path) : path_(path) {}
+  ~ProbeDumpAtExit()
+  {
+    if (path_ == nullptr)
+      return;
+    if (strcmp(path_, "-") == 0)
+    {
+      DumpProbes(std::cout);
+      return;
+    }
+    std::ofstream file(path_);
+    DumpProbes(file);
+    if (!file)
+      std::cerr << "An Error occurred: could not write " << path_ << " While dumping the probes" << std::endl;
+  }
+
+private:
+  const char *path_;
+};
+
+static void PrintUsage(std::ostream &out)
 {
-  // Get 3D magnet data
+  out << "Usage: app [--rate <Hz>] [--duration <s>] [--report <s>] [--imu-rate <Hz>] [--fusion-gain <beta>]\n"
+         "           [--mag-cal <file>] [--record <log>] [--replay <log>] [--bench <steps>]\n"
+         "           [--deadband <deg>] [--fleet <trackers>] [--threads <n>]\n"
+         "           [--max-interval <s>] [--probes <file|->] [--telemetry <file>]\n"
+         "           [--telemetry-size <MB>] [--decode <telemetry>] [--help]"
+      << std::endl;
+}
+
+static void OnSignal(int)
+{
+  if (daemon_ != nullptr)
+    daemon_->Stop();
+  if (fleet_ != nullptr)
+    fleet_->Stop();
+}
+
+int main(int argc, char **argv)
+{
+  DaemonConfig config;
+  long benchSteps = 0;
+  long fleetSize = 0;
+  long threads = 0;
+  double maxInterval = 60.0;
+  const char *probeFile = nullptr;
+  const char *decodeFile = nullptr;
+  const char *replayFile = nullptr;
+  bool imuRateSet = false;
+  for (int i = 1; i < argc; i += 2)
+  {
+    if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage(std::cout);
+      return 0;
+    }
+    // Every other option takes a value
+    if (i + 1 == argc)
+    {
+      std::cerr << "Missing value for " << argv[i] << std::endl;
+      PrintUsage(std::cerr);
+      return 1;
+    }
+    if (strcmp(argv[i], "--rate") == 0)
+      config.rate = atof(argv[i + 1]);
+    else if (strcmp(argv[i], "--duration") == 0)
+      config.duration = atof(argv[i + 1]);
+    else if (strcmp(argv[i], "--report") == 0)
+      config.reportInterval = atof(argv[i + 1]);
+    else if (strcmp(argv[i], "--imu-rate") == 0)
+    {
+      config.imuRate = atof(argv[i + 1]);
+      imuRateSet = true;
+    }
+    else if (strcmp(argv[i], "--fusion-gain") == 0)
+      config.fusionGain = atof(argv[i + 1]);
+    else if (strcmp(argv[i], "--mag-cal") == 0)
+      config.magCalFile = argv[i + 1];
+    else if (strcmp(argv[i], "--record") == 0)
+      config.recordFile = argv[i + 1];
+    else if (strcmp(argv[i], "--replay") == 0)
+      replayFile = argv[i + 1];
+    else if (strcmp(argv[i], "--deadband") == 0)
+      config.deadband = atof(argv[i + 1]);
+    else if (strcmp(argv[i], "--fleet") == 0)
+      fleetSize = atol(argv[i + 1]);
+    else if (strcmp(argv[i], "--threads") == 0)
+      threads = atol(argv[i + 1]);
+    else if (strcmp(argv[i], "--max-interval") == 0)
+      maxInterval = atof(argv[i + 1]);
+    else if (strcmp(argv[i], "--telemetry") == 0)
+      config.telemetryFile = argv[i + 1];
+    else if (strcmp(argv[i], "--telemetry-size") == 0)
+      config.telemetryRecords = static_cast<std::size_t>(atof(argv[i + 1]) * (1 << 20) / sizeof(TelemetryRecord));
+    else if (strcmp(argv[i], "--decode") == 0)
+      decodeFile = argv[i + 1];
+    else if (strcmp(argv[i], "--probes") == 0)
+      probeFile = argv[i + 1];
+    else if (strcmp(argv[i], "--bench") == 0)
+      benchSteps = atol(argv[i + 1]);
+    else
+    {
+      std::cerr << "Unknown option: " << argv[i] << std::endl;
+      PrintUsage(std::cerr);
+      return 1;
+    }
+  }
+  if (config.rate <= 0.0 || config.imuRate <= 0.0)
+  {
+    std::cerr << "Rates must be positive" << std::endl;
+    return 1;
+  }
+  if (fleetSize < 0 || threads < 0 || maxInterval < 0.0)
+  {
+    std::cerr << "Fleet size, threads and the maximum interval must not be negative" << std::endl;
+    return 1;
+  }
+  if (fleetSize > 0 && (config.recordFile != nullptr || config.magCalFile != nullptr || imuRateSet))
+  {
+    // The fleet has no sampling threads, sensor log or persisted calibration per dish
+    std::cerr << "--record, --mag-cal and --imu-rate apply to a single tracker, not with --fleet" << std::endl;
+    return 1;
+  }
+  if (config.telemetryFile != nullptr && config.telemetryRecords == 0)
+  {
+    std::cerr << "The telemetry log needs room for at least one record" << std::endl;
+    return 1;
+  }
+  if (decodeFile != nullptr)
+  {
+    // Offline: no sensors and no WMM.COF needed
+    std::size_t records = 0;
+    int errCode = DecodeTelemetry(decodeFile, std::cout, &records);
+    if (errCode != TELEMETRY_OK)
+    {
+      std::cerr << "An Error occurred: " << errCode << " While decoding " << decodeFile << std::endl;
+      return 1;
+    }
+    std::cerr << "Decoded " << records << " records" << std::endl;
+    return 0;
+  }
+  if (config.deadband < 0.0)
+  {
+    std::cerr << "The deadband must not be negative" << std::endl;
+    return 1;
+  }
+
+  ProbeDumpAtExit probeDump(probeFile);
   IMUSensor imu;
-  Point3f mag = imu.Get3DMagneticData();
-  // Calculate the magnetic north direction (θ mag)
-  double theta = atan(mag.Y / mag.X);
-  // Configure Input to get local north direction
-  IDateTime dt;
   IGPSSensor gps;
-  InData in;
-  in.decimalYear = dt.GetDecimalYear();
-  in.pos = gps.GetPositionData();
-  // Get local magnetic north direction (D)
-  auto decl = getDeclinition(&in);
-  if (decl.errCode != 0)
-  {
-    std::cerr << "An Error occurred: " << decl.errCode << " While trying to get local declinition" << std::endl;
+  IWeather weather;
+  IActuator actuator;
+  // Coefficients are parsed once for the life of the process
+  WMMEngine wmm;
+  if (wmm.GetErrCode() != NOERROR)
+  {
+    std::cerr << "An Error occurred: " << wmm.GetErrCode() << " While trying to read WMM.COF" << std::endl;
+    return 1;
+  }
+
+  if (benchSteps > 0)
+  {
+    // With --fleet: benchSteps polling ticks of the whole fleet
+    int errCode = fleetSize > 0 ? RunFleetBenchmark(wmm, static_cast<std::size_t>(fleetSize),
+                                                    static_cast<unsigned>(threads),
+                                                    static_cast<std::size_t>(benchSteps))
+                                : RunCoreBenchmark(wmm, static_cast<std::size_t>(benchSteps));
+    if (errCode != 0)
+      std::cerr << "An Error occurred: " << errCode << " While benchmarking" << std::endl;
+    return errCode != 0;
+  }
+
+  if (replayFile != nullptr)
+  {
+    ReplayResult r = ReplayLog(replayFile, wmm);
+    if (r.errCode != 0)
+    {
+      std::cerr << "An Error occurred: " << r.errCode << " While replaying " << replayFile << std::endl;
+      return 1;
+    }
+    std::cout << "Sessions: " << r.sessions << ", Ticks: " << r.ticks << " (" << r.errors << " failed)"
+              << ", Commands: " << r.commands
+              << ", Mismatches: " << r.mismatches << " (first at tick " << r.firstMismatch << ")"
+              << (r.truncated ? ", log truncated" : "") << std::endl;
+    std::cout << "Replayed " << r.logSeconds << " s of log in " << r.wallSeconds << " s" << std::endl;
+    return r.mismatches != 0;
+  }
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = OnSignal;
+  sigaction(SIGINT, &sa, nullptr);
+  sigaction(SIGTERM, &sa, nullptr);
+
+  if (fleetSize > 0)
+  {
+    // One driver set per dish; the stub drivers stand in for the per-dish buses
+    std::vector<IMUSensor> imus(fleetSize);
+    std::vector<IGPSSensor> gpss(fleetSize);
+    std::vector<IWeather> weathers(fleetSize);
+    std::vector<IActuator> actuators(fleetSize);
+    FleetController fleet(FleetConfig(config.rate, config.duration, config.reportInterval,
+                                      static_cast<unsigned>(threads), 16, config.fusionGain,
+                                      config.deadband, maxInterval),
+                          wmm);
+    for (long i = 0; i < fleetSize; i++)
+      fleet.AddTracker(imus[i], gpss[i], weathers[i], actuators[i]);
+    TelemetryLog telemetry;
+    if (config.telemetryFile != nullptr)
+    {
+      if (telemetry.Open(config.telemetryFile, config.telemetryRecords) != TELEMETRY_OK)
+      {
+        std::cerr << "An Error occurred: could not map " << config.telemetryFile << " While starting the fleet"
+                  << std::endl;
+        return 1;
+      }
+      fleet.SetTelemetry(&telemetry);
+    }
+    fleet_ = &fleet;
+    int errCode = fleet.Run();
+    fleet_ = nullptr;
+    if (errCode != 0)
+    {
+      std::cerr << "An Error occurred: " << errCode << " While running the fleet" << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  TrackingDaemon tracker(config, imu, gps, weather, wmm, actuator);
+  daemon_ = &tracker;
+  int errCode = tracker.Run();
+  daemon_ = nullptr;
+  if (errCode != 0)
+  {
+    std::cerr << "An Error occurred: " << errCode << " While tracking" << std::endl;
     return 1;
   }
-  // Calculate true north position releative to mag sensor (θ true = θ mag - D)
-  auto trueNorth = theta - decl.magData.D;
-  // Print our result to console
-  std::cout << "Magnetic Sensor North: " << theta
-            << ", Local Declinition: " << decl.magData.D
-            << ", Local Declinition Error: " << decl.magDataErr.D
-            << ", True North: " << trueNorth << " due "
-            << (trueNorth > 0 ? "East" : "West") << std::endl;
   return 0;
-}
\ No newline at end of file
+}
@@ -145,6 +145,12 @@ const int l_subcount[L_COUNT] = {64,34,20,7,3,1};
 const int b_subcount[B_COUNT] = {5,2};
 const int r_subcount[R_COUNT] = {40,10,6,2,1};
 
+// Leading terms kept by the truncated-series variant (about 0.001 deg, see SPALib tiers)
+const int l_subcount_truncated[L_COUNT] = {20,8,4,2,1,1};
+const int b_subcount_truncated[B_COUNT] = {1,0};
+const int r_subcount_truncated[R_COUNT] = {10,3,2,1,0};
+#define Y_COUNT_TRUNCATED 6
+
 ///////////////////////////////////////////////////
 ///  Earth Periodic Terms
 ///////////////////////////////////////////////////
@@ -695,37 +701,37 @@ double earth_values(double term_sum[], int count, double jme)
     return sum;
 }
 
-double earth_heliocentric_longitude(double jme)
+double earth_heliocentric_longitude(double jme, const int subcount[L_COUNT])
 {
     double sum[L_COUNT];
     int i;
 
     for (i = 0; i < L_COUNT; i++)
-        sum[i] = earth_periodic_term_summation(L_TERMS[i], l_subcount[i], jme);
+        sum[i] = earth_periodic_term_summation(L_TERMS[i], subcount[i], jme);
 
     return limit_degrees(rad2deg(earth_values(sum, L_COUNT, jme)));
 
 }
 
-double earth_heliocentric_latitude(double jme)
+double earth_heliocentric_latitude(double jme, const int subcount[B_COUNT])
 {
     double sum[B_COUNT];
     int i;
 
     for (i = 0; i < B_COUNT; i++)
-        sum[i] = earth_periodic_term_summation(B_TERMS[i], b_subcount[i], jme);
+        sum[i] = earth_periodic_term_summation(B_TERMS[i], subcount[i], jme);
 
     return rad2deg(earth_values(sum, B_COUNT, jme));
 
 }
 
-double earth_radius_vector(double jme)
+double earth_radius_vector(double jme, const int subcount[R_COUNT])
 {
     double sum[R_COUNT];
     int i;
 
     for (i = 0; i < R_COUNT; i++)
-        sum[i] = earth_periodic_term_summation(R_TERMS[i], r_subcount[i], jme);
+        sum[i] = earth_periodic_term_summation(R_TERMS[i], subcount[i], jme);
 
     return earth_values(sum, R_COUNT, jme);
 
@@ -781,13 +787,13 @@ double xy_term_summation(int i, double x[TERM_X_COUNT])
     return sum;
 }
 
-void nutation_longitude_and_obliquity(double jce, double x[TERM_X_COUNT], double *del_psi,
-                                                                          double *del_epsilon)
+void nutation_longitude_and_obliquity(double jce, double x[TERM_X_COUNT], int y_count,
+                                      double *del_psi, double *del_epsilon)
 {
     int i;
     double xy_term_sum, sum_psi=0, sum_epsilon=0;
 
-    for (i = 0; i < Y_COUNT; i++) {
+    for (i = 0; i < y_count; i++) {
         xy_term_sum  = deg2rad(xy_term_summation(i, x));
         sum_psi     += (PE_TERMS[i][TERM_PSI_A] + jce*PE_TERMS[i][TERM_PSI_B])*sin(xy_term_sum);
         sum_epsilon += (PE_TERMS[i][TERM_EPS_C] + jce*PE_TERMS[i][TERM_EPS_D])*cos(xy_term_sum);
@@ -1012,9 +1018,14 @@ double sun_rise_and_set(double *m_rts,   double *h_rts,   double *delta_prime, d
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 // Calculate required SPA parameters to get the right ascension (alpha) and declination (delta)
+// from the leading terms of each series: the earth periodic term and nutation tables are
+// ordered by decreasing amplitude, so a shorter series sums the first subcount terms of each
+// table and the first y_count nutation rows
 // Note: JD must be already calculated and in structure
 ////////////////////////////////////////////////////////////////////////////////////////////////
-void calculate_geocentric_sun_right_ascension_and_declination(spa_data *spa)
+void geocentric_sun_right_ascension_and_declination(spa_data *spa, const int l_terms[L_COUNT],
+                                                    const int b_terms[B_COUNT],
+                                                    const int r_terms[R_COUNT], int y_count)
 {
     double x[TERM_X_COUNT];
 
@@ -1024,9 +1035,9 @@ void calculate_geocentric_sun_right_ascension_and_declination(spa_data *spa)
     spa->jce = julian_ephemeris_century(spa->jde);
     spa->jme = julian_ephemeris_millennium(spa->jce);
 
-    spa->l = earth_heliocentric_longitude(spa->jme);
-    spa->b = earth_heliocentric_latitude(spa->jme);
-    spa->r = earth_radius_vector(spa->jme);
+    spa->l = earth_heliocentric_longitude(spa->jme, l_terms);
+    spa->b = earth_heliocentric_latitude(spa->jme, b_terms);
+    spa->r = earth_radius_vector(spa->jme, r_terms);
 
     spa->theta = geocentric_longitude(spa->l);
     spa->beta  = geocentric_latitude(spa->b);
@@ -1037,7 +1048,7 @@ void calculate_geocentric_sun_right_ascension_and_declination(spa_data *spa)
     x[TERM_X3] = spa->x3 = argument_latitude_moon(spa->jce);
     x[TERM_X4] = spa->x4 = ascending_longitude_moon(spa->jce);
 
-    nutation_longitude_and_obliquity(spa->jce, x, &(spa->del_psi), &(spa->del_epsilon));
+    nutation_longitude_and_obliquity(spa->jce, x, y_count, &(spa->del_psi), &(spa->del_epsilon));
 
     spa->epsilon0 = ecliptic_mean_obliquity(spa->jme);
     spa->epsilon  = ecliptic_true_obliquity(spa->del_epsilon, spa->epsilon0);
@@ -1051,6 +1062,20 @@ void calculate_geocentric_sun_right_ascension_and_declination(spa_data *spa)
     spa->delta = geocentric_declination(spa->beta, spa->epsilon, spa->lamda);
 }
 
+void calculate_geocentric_sun_right_ascension_and_declination(spa_data *spa)
+{
+    geocentric_sun_right_ascension_and_declination(spa, l_subcount, b_subcount, r_subcount, Y_COUNT);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Truncated-series variant of the above for coarse pointing (SPALib accuracy tiers)
+////////////////////////////////////////////////////////////////////////////////////////////////
+void calculate_geocentric_sun_right_ascension_and_declination_truncated(spa_data *spa)
+{
+    geocentric_sun_right_ascension_and_declination(spa, l_subcount_truncated, b_subcount_truncated,
+                                                   r_subcount_truncated, Y_COUNT_TRUNCATED);
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Calculate Equation of Time (EOT) and Sun Rise, Transit, & Set (RTS)
 ////////////////////////////////////////////////////////////////////////
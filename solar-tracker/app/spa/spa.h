@@ -198,6 +198,24 @@ double topocentric_elevation_angle_corrected(double e0, double delta_e);
 double topocentric_zenith_angle(double e);
 double topocentric_azimuth_angle_astro(double h_prime, double latitude, double delta_prime);
 double topocentric_azimuth_angle(double azimuth_astro);
+double surface_incidence_angle(double zenith, double azimuth_astro, double azm_rotation,
+                               double slope);
+
+//-------------- Time-series helpers (used by SPALib to step JD without full recomputation) -----
+double julian_day(int year, int month, int day, int hour, int minute, double second,
+                  double dut1, double tz);
+double julian_century(double jd);
+double greenwich_mean_sidereal_time(double jd, double jc);
+double sun_equatorial_horizontal_parallax(double r);
+
+// Bounds check used by spa_calculate(), returns the same error codes
+int validate_inputs(spa_data *spa);
+
+// Fill jc..delta (geocentric values) for the jd and delta_t already in the structure
+void calculate_geocentric_sun_right_ascension_and_declination(spa_data *spa);
+
+// Same outputs from the leading terms of each series only (about 0.001 deg, ~3x faster)
+void calculate_geocentric_sun_right_ascension_and_declination_truncated(spa_data *spa);
 
 // Calculate SPA output values (in structure) based on input values passed in structure
 int spa_calculate(spa_data *spa);